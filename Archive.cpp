@@ -1,5 +1,182 @@
+#include <Urho3D/Core/Thread.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
 #include "Archive.h"
 
 inline namespace Archival {
 
+namespace {
+
+/// Returns true if a step of a path may open the entry with the name as the form. Sets described if the backend checked the stored entry with DescribeEntry.
+/// Backends that can't describe their entries, like positional binary, store no names to check a group against, so only series entries get past here, for CreateSeriesEntryAt to check.
+bool HasPathEntry(Detail::Backend& backend, const String& name, Detail::Backend::EntryForm form, bool& described)
+{
+    Detail::Backend::EntryForm stored;
+    Detail::RecordFieldType type;
+    described = backend.DescribeEntry(name, stored, type);
+    if (described)
+        return stored == form;
+    if (form != Detail::Backend::SERIES_FORM)
+        return false;
+    const Detail::Backend::EntryAlternative alternative{&name, form};
+    return backend.FindEntry(&alternative, 1) != Detail::Backend::MISSING_ENTRY;
+}
+
+}
+
+unsigned ArchiveReferences::Track(const Urho3D::RefCounted *object, bool &isNew)
+{
+    isNew = false;
+    if (!object)
+        return 0;
+
+    auto it = ids_.Find(object);
+    if (it != ids_.End())
+        return it->second_;
+
+    isNew = true;
+    unsigned id = ids_.Size() + 1;
+    ids_[object] = id;
+    return id;
+}
+
+void ArchiveReferences::Add(unsigned id, Urho3D::RefCounted *object)
+{
+    objects_[id] = object;
+}
+
+Urho3D::RefCounted *ArchiveReferences::Find(unsigned id) const
+{
+    auto it = objects_.Find(id);
+    return it != objects_.End() ? it->second_.Get() : nullptr;
+}
+
+ArchiveReferences::ObjectArchiver ArchiveReferences::FindArchiver(Urho3D::StringHash type)
+{
+    auto it = Archivers().Find(type);
+    return it != Archivers().End() ? it->second_ : nullptr;
+}
+
+Urho3D::HashMap<Urho3D::StringHash, ArchiveReferences::ObjectArchiver> &ArchiveReferences::Archivers()
+{
+    static Urho3D::HashMap<Urho3D::StringHash, ObjectArchiver> archivers;
+    return archivers;
+}
+
+ArchivePrefetcher::~ArchivePrefetcher()
+{
+    if (!pending_.Empty())
+        URHO3D_LOGWARNING("ArchivePrefetcher destroyed with " + String(pending_.Size()) + " unresolved resources");
+}
+
+void ArchivePrefetcher::Prefetch(Urho3D::StringHash type, const String &name)
+{
+    if (name.Empty() || prefetched_.Contains(name))
+        return;
+    prefetched_[name] = type;
+    cache_->BackgroundLoadResource(type, name);
+}
+
+void ArchivePrefetcher::Request(Urho3D::StringHash type, const String &name, Assign assign)
+{
+    if (name.Empty())
+    {
+        assign(nullptr);
+        return;
+    }
+
+    Prefetch(type, name);
+    if (deferred_)
+        pending_.Push({type, name, std::move(assign)});
+    else
+        assign(cache_->GetResource(type, name));
+}
+
+void ArchivePrefetcher::Resolve()
+{
+    assert(Urho3D::Thread::IsMainThread());
+    // Assignments may read more archives that request more resources, so take the list first.
+    Urho3D::Vector<Deferred> pending;
+    pending.Swap(pending_);
+    for (Deferred& deferred : pending)
+        deferred.assign_(cache_->GetResource(deferred.type_, deferred.name_));
+}
+
+Urho3D::Resource* LoadArchivedResource(Urho3D::ResourceCache* cache, Urho3D::StringHash type, const String& name)
+{
+    return name.Empty() ? nullptr : cache->GetResource(type, name);
+}
+
+Archive Archive::OpenPath(const String &path)
+{
+    const Urho3D::StringVector segments = path.Split('/');
+    if (!IsInput() || segments.Empty())
+        return MakeChild(nullptr);
+
+    Archive current = OpenPathStep(segments[0], true);
+    for (unsigned i = 1; i < segments.Size(); ++i)
+    {
+        Archive next = current.OpenPathStep(segments[i], true);
+        next.parent_.Reset(new Archive(std::move(current)));
+        current = std::move(next);
+    }
+    return current;
+}
+
+bool Archive::ParsePathSegment(const String &segment, String &name, unsigned &index)
+{
+    const unsigned open = segment.Find('[');
+    const bool indexed = open != String::NPOS && segment.EndsWith("]");
+    name = indexed ? segment.Substring(0, open) : segment;
+    if (name.Empty())
+        name = GetBackend().InlineName();
+    index = indexed ? Urho3D::ToUInt(segment.Substring(open + 1, segment.Length() - open - 2)) : 0;
+    return indexed;
+}
+
+bool Archive::HasPathValue(const String &name)
+{
+    Detail::Backend::EntryForm form;
+    Detail::RecordFieldType type;
+    return GetBackend().DescribeEntry(name, form, type);
+}
+
+Archive Archive::OpenPathStep(const String &segment, bool enterInlineGroup)
+{
+    String name;
+    unsigned index;
+    const bool indexed = ParsePathSegment(segment, name, index);
+
+    bool described;
+    if (!HasPathEntry(GetBackend(), name, indexed ? Detail::Backend::SERIES_FORM : Detail::Backend::GROUP_FORM, described))
+        return MakeChild(nullptr);
+    if (!indexed)
+        return CreateGroup(name);
+
+    // Open the entry directly if the backend can, otherwise pass over the entries before it without reading them. Only backends that describe their entries skip what they pass over,
+    // and CreateSeriesEntryAt is all that checks the name of the series in those that don't.
+    Detail::Backend* backend = GetBackend().CreateSeriesEntryAt(name, index, true);
+    if (!backend)
+    {
+        if (!described)
+            return MakeChild(nullptr);
+        for (unsigned i = 0; i < index; ++i)
+        {
+            Urho3D::UniquePtr<Detail::Backend> skipped(GetBackend().CreateSeriesEntry(name, true));
+            if (!skipped)
+                return MakeChild(nullptr);
+        }
+        backend = GetBackend().CreateSeriesEntry(name, true);
+    }
+    Archive entry = MakeChild(backend);
+
+    // Groups stored in series entries are inline groups, which only some backends fold into the entry.
+    const String& inlineName = entry.GetBackend().InlineName();
+    if (!enterInlineGroup || !HasPathEntry(entry.GetBackend(), inlineName, Detail::Backend::GROUP_FORM, described))
+        return entry;
+    Archive group = entry.CreateGroup(inlineName);
+    group.parent_.Reset(new Archive(std::move(entry)));
+    return group;
+}
+
 }
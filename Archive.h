@@ -12,12 +12,20 @@
 
 #include <tuple>
 #include <functional>
+#include <initializer_list>
+#include <utility>
 #include <type_traits>
 
 #include "Utils.h"
 
 #include "ArchiveDetail.h"
 
+namespace Urho3D
+{
+class Resource;
+class ResourceCache;
+}
+
 inline namespace Archival
 {
 
@@ -153,7 +161,54 @@ EnumNamesHolder<Enum, StringsContainer, false> EnumNames(Enum& val, StringsConta
 template<typename Enum, typename StringsContainer>
 EnumNamesHolder<Enum, StringsContainer, true> EnumNamesCaseSensitive(Enum& val, StringsContainer&& names) { return {val, names}; }
 
-///TODO: Default Holder
+/// Hashes a name at compile time. Matches Urho3D::StringHash, which is case-insensitive, so the result can be compared against StringHash values at runtime.
+constexpr unsigned ArchiveNameHash(const char* str)
+{
+    unsigned hash = 0;
+    for (; *str; ++str)
+    {
+        const unsigned char c = static_cast<unsigned char>(*str);
+        hash = (c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c) + (hash << 6) + (hash << 16) - hash;
+    }
+    return hash;
+}
+
+/// One field registered with ARCHIVE_FIELDS: its name, the hash of the name and the member pointer, all available at compile time.
+template<class Class, class Member>
+struct FieldInfo
+{
+    using Type = Member;
+
+    /// The name the field is archived with.
+    const char* name;
+    /// ArchiveNameHash of the name.
+    unsigned hash;
+    /// Pointer to the member holding the field.
+    Member Class::* member;
+};
+
+/// Creates a FieldInfo for ARCHIVE_FIELD, hashing the name at compile time.
+template<class Class, class Member>
+constexpr FieldInfo<Class, Member> MakeArchiveField(const char* name, Member Class::* member)
+{
+    return {name, ArchiveNameHash(name), member};
+}
+
+/// True if the type registered its fields with ARCHIVE_FIELDS.
+template<class T, class = void>
+struct HasArchiveFields: std::false_type {};
+template<class T>
+struct HasArchiveFields<T, decltype(void(T::ArchiveFields()))>: std::true_type {};
+
+/// Utility macro to register the fields of a type in a public section of the class: ARCHIVE_FIELDS(Type, ARCHIVE_FIELD(a), ARCHIVE_FIELD_NAMED("Bee", b)).
+/// The default ArchiveValue then archives the type as a group with the fields in order, fully unrolled, and hands records of scalars to the backend in one call.
+#define ARCHIVE_FIELDS(Value_Type, ...) using ArchiveFieldsType = Value_Type; static constexpr auto ArchiveFields() { return std::make_tuple(__VA_ARGS__); }
+/// Registers a member with its own name as the archived name. For use in ARCHIVE_FIELDS.
+#define ARCHIVE_FIELD(member) ::Archival::MakeArchiveField(#member, &ArchiveFieldsType::member)
+/// Registers a member with the specified archived name. For use in ARCHIVE_FIELDS.
+#define ARCHIVE_FIELD_NAMED(name, member) ::Archival::MakeArchiveField(name, &ArchiveFieldsType::member)
+
+/// Holder to specialize ArchiveValue on for a value with a default: it is skipped on output while equal to the default, and set to the default on input when missing.
 template<class T>
 struct WithDefaultHolder
 {
@@ -161,6 +216,29 @@ struct WithDefaultHolder
     T defaultValue;
 };
 
+/// Convenience function to create a WithDefaultHolder: ar.Serialize("speed", WithDefault(speed_, 1.0f)).
+template<class T, class U>
+WithDefaultHolder<T> WithDefault(T& value, U&& defaultValue) { return {value, T(std::forward<U>(defaultValue))}; }
+
+/// Holder to specialize ArchiveValue on for a resource archived by name. On input the resource is loaded through the archive's ArchivePrefetcher and assigned through the setter on ArchivePrefetcher::Resolve,
+/// or without a prefetcher loaded synchronously through the archive's ResourceCache and assigned right away.
+template<class T>
+struct ResourceByNameHolder
+{
+    /// The resource to write on output. Null is written as an empty name.
+    T* resource;
+    /// Assigns the loaded resource on input.
+    std::function<void(T*)> setter;
+};
+
+/// Convenience function to archive a resource held in a SharedPtr by name: ar.Serialize("model", ResourceByName(model_)). With deferred prefetching the SharedPtr is assigned on ArchivePrefetcher::Resolve, so it must outlive that call.
+template<class T>
+ResourceByNameHolder<T> ResourceByName(Urho3D::SharedPtr<T>& resource) { return {resource.Get(), [&resource](T* loaded) { resource = loaded; }}; }
+/// Convenience function to archive a resource by name through a getter and setter pair: ar.Serialize("model", ResourceByName(GetModel(), [this](Model* model) { SetModel(model); })).
+/// The setter is copied and may run once the whole archive has been read, so capture by value.
+template<class T, class Setter>
+ResourceByNameHolder<T> ResourceByName(T* resource, Setter&& setter) { return {resource, std::forward<Setter>(setter)}; }
+
 /// "Magic" class that allows conditional serialization through providing Then() and Else() that will serialize based on the result of the previous Serialization/WriteConditional call.
 /// Provides an operator bool() overload so Serialization can still be checked in a boolean success/fail manner. The originating Archive must live as long as the results.
 template<class Archive, class... T>
@@ -199,6 +277,16 @@ public:
         return ret{*archive, Succeeded(), params...};
     }
 
+    /// Will serialize the passed value under the first of the names present only if the last call was a failure. The backend is probed once for all of the names.
+    template<class... Args>
+    auto Else(std::initializer_list<String> names, Args&&... params)
+    {
+        typedef decltype (archive->SerializeFirstOf(names, std::forward<Args>(params)...)) ret;
+        if (!Succeeded())
+            return archive->SerializeFirstOf(names, std::forward<Args>(params)...);
+        return ret{*archive, Succeeded(), params...};
+    }
+
     /// Utility method that returns a new result with different parameters (as if the last call had been made with those instead).
     template<class... U>
     ArchiveResult<Archive, U...> ReplaceParams(U... params)
@@ -214,6 +302,13 @@ public:
         return ElseSeq(name, typename gens<sizeof...(T)>::type()); // Item #1
     }
 
+    /// If the last call failed to serialize retry serialization to the same value under the first of the names present.
+    ArchiveResult Else(std::initializer_list<String> names)
+    {
+        using namespace detail;
+        return ElseSeq(names, typename gens<sizeof...(T)>::type());
+    }
+
     /// True if the last call succeded.
     bool Succeeded() const { return succeeded; }
     operator bool() const { return Succeeded(); }
@@ -221,8 +316,8 @@ public:
 private:
 
     /// Internal method to convert the tuple to a parameter pack for the Else("newName") call.
-    template<int ...S>
-    ArchiveResult ElseSeq(const String& name, detail::seq<S...>)
+    template<class Names, int ...S>
+    ArchiveResult ElseSeq(const Names& name, detail::seq<S...>)
     {
         return Else(name, std::get<S>(vals) ...);
     }
@@ -256,6 +351,140 @@ ArchiveResult<Archive, GetSetHolder<Getter, Setter, T>> ArchiveValue(Archive& ar
     }
 }
 
+class Archive;
+
+/// Identity of the shared objects archived through an Archive and the groups created from it, so that an object reachable through several SharedPtrs is stored once and loaded back as a single instance.
+/// Output assigns each object a compact ID on first sight (0 is null); input maps IDs back to the loaded objects. Enable with Archive::TrackReferences.
+class ArchiveReferences: public Urho3D::RefCounted
+{
+public:
+    /// Archives the contents of an object of a registered type under the name.
+    using ObjectArchiver = bool(*)(Archive& ar, const String& name, Urho3D::Object* object);
+
+    /// Construct. The context is used to create objects by type on input.
+    explicit ArchiveReferences(Urho3D::Context* context): context_(context) {}
+
+    /// Returns the context objects are created with.
+    Urho3D::Context* GetContext() const { return context_; }
+
+    /// Returns the ID of the object for output, or 0 for null. Sets isNew if this is the first time the object is archived, assigning it the next ID.
+    unsigned Track(const Urho3D::RefCounted* object, bool& isNew);
+    /// Stores a loaded object under its ID. Call before loading the object's contents so that cycles resolve to it.
+    void Add(unsigned id, Urho3D::RefCounted* object);
+    /// Returns the object loaded with the ID, or null if it has not been loaded yet.
+    Urho3D::RefCounted* Find(unsigned id) const;
+
+    /// Registers the ArchiveValue of a type derived from Object, so that objects held through a base class SharedPtr are archived (and created) as their actual type. Not thread safe: register during startup.
+    template<class T>
+    static void RegisterObjectType();
+    /// Returns the archiver registered for the type, or null.
+    static ObjectArchiver FindArchiver(Urho3D::StringHash type);
+
+private:
+    /// Returns the registered archivers by type.
+    static Urho3D::HashMap<Urho3D::StringHash, ObjectArchiver>& Archivers();
+
+    /// IDs of the objects written so far.
+    Urho3D::HashMap<const Urho3D::RefCounted*, unsigned> ids_;
+    /// Objects loaded so far by ID.
+    Urho3D::HashMap<unsigned, Urho3D::SharedPtr<Urho3D::RefCounted>> objects_;
+    /// Context to create objects with.
+    Urho3D::Context* context_;
+};
+
+/// Background loading of the resources an input archive references through ResourceByName. Each resource is queued with ResourceCache::BackgroundLoadResource as soon as its name is read,
+/// and assigning it is deferred until Resolve, so resources load while the rest of the archive is read rather than stalling one at a time. Enable with Archive::PrefetchResources.
+/// Resolve is never called implicitly: the archive may be released on any thread, and the objects the setters assign to may be gone by then.
+class ArchivePrefetcher: public Urho3D::RefCounted
+{
+public:
+    /// Assigns a loaded resource, or null if it failed to load.
+    using Assign = std::function<void(Urho3D::Resource*)>;
+
+    /// Construct. Without deferral, resources are still queued as they are read but assigned right away, which only helps when the same name is read again later.
+    explicit ArchivePrefetcher(Urho3D::ResourceCache* cache, bool deferred = true): cache_(cache), deferred_(deferred) {}
+    /// Destruct. Assignments that were never resolved are dropped.
+    ~ArchivePrefetcher() override;
+
+    /// Queues the resource for background loading, once per name.
+    void Prefetch(Urho3D::StringHash type, const String& name);
+    /// Prefetches the resource, then assigns it now or on Resolve.
+    void Request(Urho3D::StringHash type, const String& name, Assign assign);
+    /// Assigns every deferred resource in the order they were read, waiting for those that are still loading. Main thread only: call once the archive has been read.
+    void Resolve();
+
+    /// Returns the number of distinct resources queued.
+    unsigned GetNumPrefetched() const { return prefetched_.Size(); }
+
+private:
+    /// A deferred assignment.
+    struct Deferred
+    {
+        Urho3D::StringHash type_;
+        String name_;
+        Assign assign_;
+    };
+
+    /// Cache that loads the resources.
+    Urho3D::ResourceCache* cache_;
+    /// Resource names queued so far, with their type.
+    Urho3D::HashMap<String, Urho3D::StringHash> prefetched_;
+    /// Assignments waiting for Resolve.
+    Urho3D::Vector<Deferred> pending_;
+    /// True to defer assignments until Resolve.
+    bool deferred_;
+};
+
+/// Gets the resource from the cache, waiting for it to load. Returns null for an empty name.
+Urho3D::Resource* LoadArchivedResource(Urho3D::ResourceCache* cache, Urho3D::StringHash type, const String& name);
+
+/// Overload to ArchiveValue for a resource archived by its name. Input requests the resource from the archive's ArchivePrefetcher, or without one gets it synchronously from the archive's ResourceCache.
+template<class Archive, typename T>
+ArchiveResult<Archive> ArchiveValue(Archive& ar, const String& name, ResourceByNameHolder<T>&& holder)
+{
+    String resourceName;
+    if (!ar.IsInput())
+    {
+        if (holder.resource)
+            resourceName = holder.resource->GetName();
+        return {ar, ar.Serialize(name, resourceName)};
+    }
+
+    ArchivePrefetcher* prefetcher = ar.GetPrefetcher();
+    if (!prefetcher && !ar.GetResourceCache())
+    {
+        URHO3D_LOGERROR("ResourceByName requires Archive::SetResourceCache or Archive::PrefetchResources on input. Name=" + name);
+        return {ar, false};
+    }
+    if (!ar.Serialize(name, resourceName))
+        return {ar, false};
+
+    if (!prefetcher)
+    {
+        holder.setter(static_cast<T*>(LoadArchivedResource(ar.GetResourceCache(), T::GetTypeStatic(), resourceName)));
+        return {ar, true};
+    }
+    auto setter = std::move(holder.setter);
+    prefetcher->Request(T::GetTypeStatic(), resourceName, [setter](Urho3D::Resource* resource) { setter(static_cast<T*>(resource)); });
+    return {ar, true};
+}
+
+/// Overload to ArchiveValue for a value with a default. Output skips the value while it equals the default; input sets the default when the value is missing.
+/// Presence is recorded through Backend::WritePresence, so a missing value costs a single lookup (or a bit of the group's presence bitmap for binary) rather than a failed Get.
+template<class Archive, typename T>
+ArchiveResult<Archive, T> ArchiveValue(Archive& ar, const String& name, WithDefaultHolder<T>&& holder)
+{
+    bool present = ar.IsInput() || !(holder.archiveValue == holder.defaultValue);
+    if (!ar.GetBackend().WritePresence(name, present, ar.IsInput()))
+    {
+        if (ar.IsInput())
+            holder.archiveValue = holder.defaultValue;
+        return {ar, true, holder.archiveValue};
+    }
+    bool good = ar.Serialize(name, holder.archiveValue);
+    return {ar, good, holder.archiveValue};
+}
+
 /// Archives have the ability to serialize values to specified
 class Archive
 {
@@ -271,25 +500,28 @@ public:
     bool IsInput() const { return isInput_; }
 
     /// Create a group in the archive with the specified name.
-    /// Will try to create the group inline if the Backend::InlineName() string is passed.
+    /// Will try to create the group inline if the Backend::InlineName() token is passed.
     /// Inline means {"old" : "val", **{ENTRY} } using python syntax instead of {"old" : "val", "value" : {ENTRY}}.
     Archive CreateGroup(const String& name)
     {
-        if (auto* b = GetBackend().CreateGroup(name, IsInput()))
-            return Archive(IsInput(), b);
-        return Archive(IsInput());
+        return MakeChild(GetBackend().CreateGroup(name, IsInput()));
     }
 
     /// Create a new series entry in the archive with the specified name.
-    /// Will try to create the series inline if the Backend::InlineName() string is passed.
+    /// Will try to create the series inline if the Backend::InlineName() token is passed.
     /// Inline means "x" : [ {ENTRY} ] instead of "x" : { "value" : [ {ENTRY} ] }
     Archive CreateSeriesEntry(const String& name)
     {
 //        if (Urho3D::UniquePtr<Detail::Backend> b = GetBackend().CreateSeriesEntry(name, IsInput()))
 //            return Archive(IsInput(), std::move(b));
-        if (auto b = GetBackend().CreateSeriesEntry(name, IsInput()))
-            return Archive(IsInput(), b);
-        return Archive(IsInput());
+        return MakeChild(GetBackend().CreateSeriesEntry(name, IsInput()));
+    }
+
+    /// Create or open the series entry with the specified name at the index directly, without going through the entries before it. Independent of the entries CreateSeriesEntry goes through.
+    /// Supported by JSON, and by binary archives made with BinaryBackend::MakeIndexedArchive for the series whose size was last serialized. Otherwise, and past the end of the series, fails every operation.
+    Archive CreateSeriesEntry(const String& name, unsigned index)
+    {
+        return MakeChild(GetBackend().CreateSeriesEntryAt(name, index, IsInput()));
     }
 
     /// Utility method to create a series with the sentinel inline name.
@@ -321,6 +553,20 @@ public:
         return true;
     }
 
+    /// Serializes a whole dynamically sized series: the size followed by every element inline. The size is announced before any entry is created so the backend can allocate the series once.
+    /// Requires Size(), Resize() and operator[] on the container.
+    template<class Resizable>
+    bool SerializeSeries(const String& name, Resizable& v)
+    {
+        if (!SerializeSeriesSize(name, v))
+            return false;
+
+        bool good = true;
+        for (unsigned i = 0; i < v.Size(); ++i)
+            good &= static_cast<bool>(CreateSeriesEntry(name).SerializeInline(v[i]));
+        return good;
+    }
+
     /// Serializes dynamically named elements, such as the entries of a HashMap. May or may not perform actual serialization with all Backends.
     /// Pushes names of serialized elements to the vector on input or (possibly) reads from it on output.
     /// Will clear the vector before inserting entries into it.
@@ -336,6 +582,53 @@ public:
         }
     }
 
+    /// Visits every entry of the group on input without first copying out the entry names. Called as visitor(key, entry, entryName): serialize the value with entry.Serialize(entryName, ...).
+    /// If the backend supports Backend::VisitEntries, entry is a child positioned on the value (so no second lookup by key is needed); otherwise it falls back to GetEntryNames with entry being this archive and entryName the key.
+    template<class Visitor>
+    bool VisitEntries(Visitor&& visitor)
+    {
+        if (!IsInput())
+            return false;
+
+        bool good = true;
+        if (GetBackend().VisitEntries([&](const String& key, Detail::Backend* backend)
+                {
+                    Archive entry = MakeChild(backend);
+                    good &= static_cast<bool>(visitor(key, entry, entry.GetBackend().InlineName()));
+                }))
+            return good;
+
+        Urho3D::StringVector names;
+        if (!GetBackend().GetEntryNames(names))
+            return false;
+        for (const String& key : names)
+            good &= static_cast<bool>(visitor(key, *this, key));
+        return good;
+    }
+
+    /// Opens the group or series entry at the path on input without running the ArchiveValue code of anything else. Segments are separated by '/'; name[k] is entry k of the series name, and [k] alone of the inline series.
+    /// Each step is checked with Backend::DescribeEntry in self-describing backends (JSON, tagged binary). If a step is missing, the result fails every operation.
+    /// The tagged binary layout skips what it passes over without decoding it. Other binary layouts store no names, so the only steps they resolve are name[k] into the series whose size was last serialized
+    /// with this archive, through the offset table of the indexed layout. The result keeps the groups along the path open, and this archive must outlive it.
+    Archive OpenPath(const String& path);
+
+    /// Loads the value at the path: the last segment names the value (or series entry) in the group the rest opens with OpenPath.
+    template<class T>
+    bool SerializePath(const String& path, T& value)
+    {
+        if (!IsInput())
+            return false;
+        const unsigned split = path.FindLast('/');
+        if (split != String::NPOS)
+            return OpenPath(path.Substring(0, split)).SerializePath(path.Substring(split + 1), value);
+
+        String name;
+        unsigned index;
+        if (ParsePathSegment(path, name, index))
+            return static_cast<bool>(OpenPathStep(path, false).SerializeInline(value));
+        return HasPathValue(name) && static_cast<bool>(Serialize(name, value));
+    }
+
     /// Magic function to allow skipping writing of values if appropriate. Follow with .Then(...).
     /// Condition may be saved to the file (e.g. BinaryBackend) to allow matching brancing on load.
     ArchiveResult<Archive> WriteConditional(bool value)
@@ -350,6 +643,37 @@ public:
         return ArchiveValue(*this, name, std::forward<T>(val));
     }
 
+    /// Saves/Loads a value under the first of the names that is present in the archive. Output always uses the first name.
+    /// On input the backend is asked once which of the names it holds (Backend::FindEntry), so legacy fallbacks don't each cost a failed lookup.
+    template<class T>
+    auto SerializeFirstOf(std::initializer_list<String> names, T&& val)
+    {
+        typedef decltype (Serialize(*names.begin(), std::forward<T>(val))) ret;
+        assert(names.size() > 0 && names.size() <= Detail::Backend::MAX_ENTRY_ALTERNATIVES);
+
+        unsigned match = 0;
+        if (IsInput())
+        {
+            Detail::Backend::EntryAlternative alternatives[Detail::Backend::MAX_ENTRY_ALTERNATIVES];
+            unsigned count = 0;
+            for (const String& name : names)
+                alternatives[count++] = {&name, Detail::Backend::ANY_FORM};
+
+            match = GetBackend().FindEntry(alternatives, count);
+            if (match == Detail::Backend::MISSING_ENTRY)
+                return ret{*this, false, val};
+            if (match == Detail::Backend::UNKNOWN_ENTRY)
+            {
+                // The backend can't tell, so try each name in turn.
+                for (const String& name : names)
+                    if (auto res = Serialize(name, std::forward<T>(val)))
+                        return res;
+                return ret{*this, false, val};
+            }
+        }
+        return Serialize(names.begin()[match], std::forward<T>(val));
+    }
+
     /// Saves/Loads a value inline (if possible) to/from the archive based on IsInput(). Inline means [VAL] instead of [{"value" : VAL}].
     template<class...T>
     auto SerializeInline(T&&...args)
@@ -372,7 +696,61 @@ public:
     /// Returns a reference to the current backend. Will return a reference to the NpOpBackend if no backend is present.
     Detail::Backend& GetBackend() { assert(backend_); return *backend_; }
 
+    /// Enables shared reference tracking for this archive and the groups and series entries created from it afterwards. Call on the root archive so IDs are shared across the whole file.
+    /// The context is required on input to create objects derived from Object by type.
+    Archive& TrackReferences(Urho3D::Context* context = nullptr)
+    {
+        if (!references_)
+            references_ = new ArchiveReferences(context);
+        return *this;
+    }
+    /// Returns the reference table, or null if references are not tracked.
+    ArchiveReferences* GetReferences() const { return references_; }
+
+    /// Enables background prefetching of the resources archived with ResourceByName for this archive and the groups and series entries created from it afterwards. Call on the root input archive,
+    /// then call GetPrefetcher()->Resolve() on the main thread once it has been read. Without deferral, each resource is assigned as soon as it is read.
+    Archive& PrefetchResources(Urho3D::ResourceCache* cache, bool deferred = true)
+    {
+        if (!prefetcher_)
+            prefetcher_ = new ArchivePrefetcher(cache, deferred);
+        resourceCache_ = cache;
+        return *this;
+    }
+    /// Returns the resource prefetcher, or null if resources are not prefetched.
+    ArchivePrefetcher* GetPrefetcher() const { return prefetcher_; }
+
+    /// Sets the cache resources archived with ResourceByName are loaded from synchronously when they aren't prefetched, for this archive and the groups and series entries created from it afterwards.
+    Archive& SetResourceCache(Urho3D::ResourceCache* cache) { resourceCache_ = cache; return *this; }
+    /// Returns the resource cache, or null if none was set.
+    Urho3D::ResourceCache* GetResourceCache() const { return resourceCache_; }
+
 private:
+    /// Wraps a backend created from this archive's backend, sharing the reference table and resource prefetcher. Uses the NoOpBackend if it is null.
+    Archive MakeChild(Detail::Backend* backend)
+    {
+        Archive child = backend ? Archive(IsInput(), backend) : Archive(IsInput());
+        child.references_ = references_;
+        child.prefetcher_ = prefetcher_;
+        child.resourceCache_ = resourceCache_;
+        return child;
+    }
+
+    /// Splits a path segment into its name (the inline name if empty) and, for name[k], the index. Returns true if it has an index.
+    bool ParsePathSegment(const String& segment, String& name, unsigned& index);
+    /// Returns true if the backend describes a stored entry with the name, so that the last segment of a path never reads whatever value comes next.
+    bool HasPathValue(const String& name);
+    /// Opens one segment of a path. See OpenPath. For a series entry holding a group, opens that group if enterInlineGroup is set.
+    Archive OpenPathStep(const String& segment, bool enterInlineGroup);
+
+    /// The archive this one was opened from by OpenPath, kept open as long as this one. Declared before the backend so that it closes after it.
+    Urho3D::UniquePtr<Archive> parent_;
+    /// Identity of shared objects archived so far, shared with child archives. Null unless TrackReferences was called.
+    Urho3D::SharedPtr<ArchiveReferences> references_;
+    /// Resource prefetcher shared with child archives. Null unless PrefetchResources was called.
+    Urho3D::SharedPtr<ArchivePrefetcher> prefetcher_;
+    /// Cache to load resources from, shared with child archives. Null unless SetResourceCache or PrefetchResources was called.
+    Urho3D::ResourceCache* resourceCache_{};
+
     /// Stores the backend for the archive. The backend handles the actual saving and loading of the "basic" types, allowing us to serialize classes simply by overloading the ArchiveValue function.
     Urho3D::UniquePtr<Detail::Backend> backend_;
 
@@ -385,13 +763,16 @@ private:
 };
 
 
-/// The default implementation of archiving a type. Defers to Get<T>/Set<T>.
+/// The default implementation of archiving a type. Defers to Get<T>/Set<T>, or archives the fields of a type registered with ARCHIVE_FIELDS as a group.
 /// Get/Set must exist for the types bool, int, unsigned, float, and String.
 ///         Maybe also for null, (unsigned) short, (unsigned) long, and double.
 /// Values may possibly be cast between different types by the underlying implementation, e.g. XML stores all as a String.
 /// The name "value" is reserved. It is used to handle the case of inline values (like JSON [1,2,3]).
+namespace detail {
+
+/// Default archiving of a type without registered fields: defers to the backend's Get/Set.
 template<class Archive, typename T>
-ArchiveResult<Archive, T> ArchiveValue(Archive& ar, const String& name, T& value)
+ArchiveResult<Archive, T> ArchiveValueDefault(Archive& ar, const String& name, T& value, std::false_type)
 {
     if (ar.IsInput())
         return ArchiveResult<Archive, T>(ar, ar.GetBackend().Get(name, value), value);
@@ -399,6 +780,53 @@ ArchiveResult<Archive, T> ArchiveValue(Archive& ar, const String& name, T& value
         return ArchiveResult<Archive, T>(ar, ar.GetBackend().Set(name, value), value);
 }
 
+/// True if every type is a scalar that can be passed in a Backend record.
+template<class... T>
+struct AllRecordScalars: std::true_type {};
+template<class T, class... Rest>
+struct AllRecordScalars<T, Rest...>: std::integral_constant<bool, Detail::RecordFieldTypeOf<T>::value != Detail::RECORD_NONE && AllRecordScalars<Rest...>::value> {};
+
+/// Archives every registered field of the value into the group, unrolled at compile time.
+template<class Archive, typename T, class Fields, std::size_t... I>
+bool ArchiveFieldsUnrolled(Archive& group, T& value, const Fields& fields, std::index_sequence<I...>)
+{
+    static_assert(sizeof...(I) > 0, "ARCHIVE_FIELDS requires at least one field.");
+    // Built once per type, so archiving doesn't construct a String per field.
+    static const String names[] = {String(std::get<I>(fields).name)...};
+
+    // A failed record may have consumed some of its fields already, so it never falls back to archiving them one at a time.
+    if (AllRecordScalars<typename std::tuple_element<I, Fields>::type::Type...>::value && group.GetBackend().SupportsRecords())
+    {
+        Detail::RecordField record[] = {{&names[I], std::get<I>(fields).hash,
+                Detail::RecordFieldTypeOf<typename std::tuple_element<I, Fields>::type::Type>::value,
+                &(value.*(std::get<I>(fields).member))}...};
+        return group.IsInput() ? group.GetBackend().GetRecord(record, sizeof...(I)) : group.GetBackend().SetRecord(record, sizeof...(I));
+    }
+
+    bool good = true;
+    using expand = int[];
+    (void)expand{0, (good &= static_cast<bool>(group.Serialize(names[I], value.*(std::get<I>(fields).member))), 0)...};
+    return good;
+}
+
+/// Default archiving of a type with registered fields: a group holding every field.
+template<class Archive, typename T>
+ArchiveResult<Archive, T> ArchiveValueDefault(Archive& ar, const String& name, T& value, std::true_type)
+{
+    constexpr auto fields = T::ArchiveFields();
+    auto group = ar.CreateGroup(name);
+    bool good = ArchiveFieldsUnrolled(group, value, fields, std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+    return {ar, good, value};
+}
+
+}
+
+template<class Archive, typename T>
+ArchiveResult<Archive, T> ArchiveValue(Archive& ar, const String& name, T& value)
+{
+    return detail::ArchiveValueDefault(ar, name, value, HasArchiveFields<T>());
+}
+
 
 /// Overload to ArchiveValue that uses the provided enum names to store the enum based on the Backend's PrefersBinaryValue().
 template<typename Enum, typename Strings, bool CASE_SENSITIVE>
@@ -416,7 +844,30 @@ ArchiveResult<Archive, EnumNamesHolder<Enum, Strings, CASE_SENSITIVE>> ArchiveVa
 //    if (ar.IsInput())
 //    {
         bool good = true;
-        if (ar.GetBackend().PrefersBinaryData())
+        bool prefersBinary = ar.GetBackend().PrefersBinaryData();
+        if (ar.IsInput())
+        {
+            // Ask which form is stored up front so we don't pay for a failed Get before the Else.
+            Detail::Backend::EntryAlternative forms[] = {{&name, Detail::Backend::NUMBER_FORM}, {&name, Detail::Backend::STRING_FORM}};
+            switch (ar.GetBackend().FindEntry(forms, 2))
+            {
+            case 0:
+                good = ar.Serialize(name, val);
+                ar.UnHint(Detail::Hint::SUGGESTED_OPTIONS);
+                return {ar, good, enumNames};
+            case 1:
+                good = ar.Serialize(name, GetSet([&](){return enumNames.EnumToString();},
+                [&](const String& name){ return enumNames.StringToEnum(name);}));
+                ar.UnHint(Detail::Hint::SUGGESTED_OPTIONS);
+                return {ar, good, enumNames};
+            case Detail::Backend::MISSING_ENTRY:
+                ar.UnHint(Detail::Hint::SUGGESTED_OPTIONS);
+                return {ar, false, enumNames};
+            default:
+                break;
+            }
+        }
+        if (prefersBinary)
         {
             good = ar.Serialize(name, val)
                     .Else(name, GetSet([&](){return enumNames.EnumToString();},
@@ -446,6 +897,186 @@ ArchiveResult<Archive, EnumNamesHolder<Enum, Strings, CASE_SENSITIVE>> ArchiveVa
 //    }
 }
 
+/// Overload to ArchiveValue for an Urho3D::Vector. Stores it as a series with the specified name.
+template<class Archive, typename T>
+ArchiveResult<Archive, Urho3D::Vector<T>> ArchiveValue(Archive& ar, const String& name, Urho3D::Vector<T>& value)
+{
+    return {ar, ar.SerializeSeries(name, value), value};
+}
+
+/// Overload to ArchiveValue for an Urho3D::PODVector. Stores it as a series with the specified name.
+template<class Archive, typename T>
+ArchiveResult<Archive, Urho3D::PODVector<T>> ArchiveValue(Archive& ar, const String& name, Urho3D::PODVector<T>& value)
+{
+    return {ar, ar.SerializeSeries(name, value), value};
+}
+
+/// Overload to ArchiveValue for a byte buffer (image data, compiled shaders, ...). Backends that support buffers store it in one piece: length-prefixed raw bytes for binary, base64 for JSON.
+/// Others, and input stored as a series, fall back to a series of bytes.
+template<class Archive>
+ArchiveResult<Archive, Urho3D::PODVector<unsigned char>> ArchiveValue(Archive& ar, const String& name, Urho3D::PODVector<unsigned char>& value)
+{
+    if (ar.IsInput() ? ar.GetBackend().Get(name, value) : ar.GetBackend().Set(name, value))
+        return {ar, true, value};
+    return {ar, ar.SerializeSeries(name, value), value};
+}
+
+/// Overload to ArchiveValue for an Urho3D::HashMap keyed by String. Stores it as a group with one entry per key. Input adds to (rather than replaces) the existing entries.
+template<class Archive, typename T>
+ArchiveResult<Archive, Urho3D::HashMap<String, T>> ArchiveValue(Archive& ar, const String& name, Urho3D::HashMap<String, T>& value)
+{
+    auto group = ar.CreateGroup(name);
+    bool good = true;
+    if (ar.IsInput())
+    {
+        good = group.VisitEntries([&](const String& key, Archive& entry, const String& entryName)
+        {
+            return entry.Serialize(entryName, value[key]);
+        });
+    }
+    else
+    {
+        Urho3D::StringVector names;
+        names.Reserve(value.Size());
+        for (auto it = value.Begin(); it != value.End(); ++it)
+            names.Push(it->first_);
+        good = group.SerializeEntryNames(names);
+        for (auto it = value.Begin(); it != value.End(); ++it)
+            good &= static_cast<bool>(group.Serialize(it->first_, it->second_));
+    }
+    return {ar, good, value};
+}
+
+template<class T>
+void ArchiveReferences::RegisterObjectType()
+{
+    Archivers()[T::GetTypeStatic()] = [](Archive& ar, const String& name, Urho3D::Object* object) -> bool
+    {
+        return ar.Serialize(name, *static_cast<T*>(object));
+    };
+}
+
+namespace detail {
+
+/// Archives the type and contents of the first occurrence of an object derived from Object, creating it through the Context factory on input.
+/// The type is stored as its hash for binary backends and as the type name otherwise.
+template<class Archive, typename T>
+bool ArchiveReferenced(Archive& group, ArchiveReferences& references, unsigned id, Urho3D::SharedPtr<T>& value, std::true_type)
+{
+    Urho3D::StringHash type;
+    if (group.IsInput())
+    {
+        if (group.GetBackend().PrefersBinaryData())
+        {
+            unsigned hash = 0;
+            if (!group.Serialize("type", hash))
+                return false;
+            type = Urho3D::StringHash(hash);
+        }
+        else
+        {
+            String typeName;
+            if (!group.Serialize("type", typeName))
+                return false;
+            type = Urho3D::StringHash(typeName);
+        }
+
+        Urho3D::Context* context = references.GetContext();
+        if (!context)
+        {
+            URHO3D_LOGERROR("Loading shared references to Objects requires a Context passed to Archive::TrackReferences.");
+            return false;
+        }
+        Urho3D::SharedPtr<Urho3D::Object> created = context->CreateObject(type);
+        T* object = dynamic_cast<T*>(created.Get());
+        if (!object)
+        {
+            URHO3D_LOGERROR("Could not create shared reference of type " + type.ToString() + " as " + T::GetTypeNameStatic());
+            return false;
+        }
+        value = object;
+        references.Add(id, object);
+    }
+    else
+    {
+        type = value->GetType();
+        unsigned hash = type.Value();
+        String typeName = value->GetTypeName();
+        if (!(group.GetBackend().PrefersBinaryData() ? group.Serialize("type", hash) : group.Serialize("type", typeName)))
+            return false;
+    }
+
+    if (ArchiveReferences::ObjectArchiver archiver = ArchiveReferences::FindArchiver(type))
+        return archiver(group, "value", value);
+    if (type != T::GetTypeStatic())
+        URHO3D_LOGWARNING("Archiving shared reference of unregistered type " + type.ToString() + " as " + T::GetTypeNameStatic());
+    return group.Serialize("value", *value);
+}
+
+/// Archives the contents of the first occurrence of an object not derived from Object, creating it with new on input.
+template<class Archive, typename T>
+bool ArchiveReferenced(Archive& group, ArchiveReferences& references, unsigned id, Urho3D::SharedPtr<T>& value, std::false_type)
+{
+    if (group.IsInput())
+    {
+        value = new T();
+        references.Add(id, value.Get());
+    }
+    return group.Serialize("value", *value);
+}
+
+}
+
+/// Overload to ArchiveValue for a SharedPtr. Requires references to be tracked (Archive::TrackReferences on the root archive): an object reachable through several pointers is stored once and later occurrences store only its ID,
+/// and on load every occurrence resolves to the same instance. Types derived from Object are created through the Context factory by type, and archived as their actual type if registered with ArchiveReferences::RegisterObjectType.
+/// Stored as a group {"ref" : ID, "type" : TYPE, "value" : {...}} where type and value are only present for the first occurrence and ID 0 is null.
+template<class Archive, typename T>
+ArchiveResult<Archive, Urho3D::SharedPtr<T>> ArchiveValue(Archive& ar, const String& name, Urho3D::SharedPtr<T>& value)
+{
+    // Enabling tracking here would give every sibling its own table (and no Context on input), so require the root to have done it.
+    ArchiveReferences* references = ar.GetReferences();
+    if (!references)
+    {
+        URHO3D_LOGERROR("Archiving a SharedPtr requires Archive::TrackReferences on the root archive. Name=" + name);
+        return {ar, false, value};
+    }
+    auto group = ar.CreateGroup(name);
+    using IsObject = std::is_base_of<Urho3D::Object, T>;
+
+    if (!ar.IsInput())
+    {
+        bool isNew = false;
+        unsigned id = references->Track(value.Get(), isNew);
+        bool good = group.Serialize("ref", id);
+        if (good && id && group.WriteConditional(isNew))
+            good = detail::ArchiveReferenced(group, *references, id, value, IsObject());
+        return {ar, good, value};
+    }
+
+    unsigned id = 0;
+    if (!group.Serialize("ref", id))
+        return {ar, false, value};
+    if (!id)
+    {
+        value.Reset();
+        return {ar, true, value};
+    }
+
+    // Binary backends store whether this is the first occurrence, text backends just see whether the ID was loaded already.
+    bool isNew = group.WriteConditional(false);
+    if (Urho3D::RefCounted* existing = references->Find(id))
+    {
+        T* object = dynamic_cast<T*>(existing);
+        value = object;
+        return {ar, object != nullptr, value};
+    }
+    if (!isNew)
+        return {ar, false, value};
+
+    bool good = detail::ArchiveReferenced(group, *references, id, value, IsObject());
+    return {ar, good, value};
+}
+
 /// Calls resize on the passed object to generate a series of that size. Specialized to supply an int as well.
 template<>
 inline bool Archive::SerializeSeriesSize(const String& name, unsigned& size)
@@ -4,6 +4,7 @@
 #include <Urho3D/Core/Context.h>
 
 #include "ArchiveDetail.h"
+#include "Base64.h"
 
 #include "Archive.h"
 
@@ -14,28 +15,39 @@ namespace Detail {
 
 const Hint Hint::EMPTY_HINT{OUTPUT_NONE, {}, {}};
 
+const String Backend::INLINE_TOKEN{"\x1F" "value"};
+
 
 Archive JSONBackend::MakeArchive(bool isInput, JSONValue &val)
 {
     return Archive(isInput, new JSONBackend(val, isInput));
 }
 
+Archive JSONBackend::MakeArchive(const JSONValue &val)
+{
+    return Archive(true, new JSONBackend(const_cast<JSONValue&>(val), true));
+}
+
 Backend *JSONBackend::CreateGroup(const String &name, bool isInput)
 {
-    auto& obj = GetSeriesObject(isInput);
+    JSONValue* series = GetSeriesObject(isInput);
+    if (!series)
+        return nullptr;
+    auto& obj = *series;
     if (isInput)
     {
-        if (name == InlineName()
-                && !(obj.Contains(name) && obj[name].IsObject()))
+        // Lookups only, never operator[], so that input never writes to the document.
+        JSONValue* member = FindMember(obj, KeyName(name));
+        if (IsInline(name) && !(member && member->IsObject()))
             return new JSONBackend(obj, isInput);
-        else if (!obj.Contains(name))
+        else if (!member)
             return nullptr;
         else
-            return new JSONBackend(obj[name], isInput);
+            return new JSONBackend(*member, isInput);
     }
     else
     {
-        if (name == InlineName())
+        if (IsInline(name))
             return new JSONBackend(obj = Urho3D::JSONObject(), isInput);
         else
             return new JSONBackend(obj[name] = Urho3D::JSONObject(), isInput);
@@ -45,27 +57,39 @@ Backend *JSONBackend::CreateGroup(const String &name, bool isInput)
 
 Backend *JSONBackend::CreateSeriesEntry(const String &name, bool isInput)
 {
-    if (!entries_.Contains(name))
-        entries_[name] = 0;
-    else
-        entries_[name] += 1;
+    auto entry = entries_.Find(name);
+    unsigned idx = entry == entries_.End() ? (entries_[name] = 0) : ++entry->second_;
+    return MakeSeriesEntry(name, idx, isInput);
+}
 
+Backend *JSONBackend::CreateSeriesEntryAt(const String &name, unsigned index, bool isInput)
+{
+    unsigned size;
+    if (isInput && (!GetSeriesSize(name, size) || index >= size))
+        return nullptr;
+    return MakeSeriesEntry(name, index, isInput);
+}
+
+Backend *JSONBackend::MakeSeriesEntry(const String &name, unsigned idx, bool isInput)
+{
     if (isInput)
     {
 
-        auto& obj = GetSeriesObject(isInput);
-        if (name == InlineName() && obj.IsArray())
+        JSONValue* series = GetSeriesObject(isInput);
+        if (!series)
+            return nullptr;
+        auto& obj = *series;
+        if (IsInline(name) && obj.IsArray())
         {
             auto backend = new JSONBackend(obj, isInput);
-            backend->seriesEntry_ = entries_[name];
+            backend->seriesEntry_ = idx;
             return backend;
         }
 
-        if (obj.Contains(name))
+        if (JSONValue* array = FindMember(obj, KeyName(name)))
         {
-            unsigned e = entries_[name];
-            auto backend = new JSONBackend(obj[name], isInput);
-            backend->seriesEntry_ = e;
+            auto backend = new JSONBackend(*array, isInput);
+            backend->seriesEntry_ = idx;
             return backend;
         }
         else
@@ -82,26 +106,33 @@ Backend *JSONBackend::CreateSeriesEntry(const String &name, bool isInput)
         //            obj.Resize(Urho3D::Max(idx+1,obj.Size()));
         //            return JSONArchive(false, obj[idx] = Urho3D::JSONObject());
 
-        auto idx = entries_[name];
         JSONValue& array = MakeSeriesEntryInternal(name, idx + 1);
-        return new JSONBackend(array[idx] = Urho3D::JSONObject(),isInput);
+        // Construct the entry in place (the slot is normally a null left by SetSeriesSize) instead of assigning a temporary object.
+        JSONValue& value = array[idx];
+        if (!value.IsNull())
+            value.SetType(JSONValueType::JSON_NULL);
+        value.SetType(JSONValueType::JSON_OBJECT);
+        return new JSONBackend(value, isInput);
     }
 }
 
 bool JSONBackend::SetSeriesSize(const String &name, const unsigned &size)
 {
-    // Just defer to the magic of MakeSeriesEntryInternal
+    // Just defer to the magic of MakeSeriesEntryInternal, which allocates the whole array once.
     MakeSeriesEntryInternal(name, size);
     return true;
 }
 
 bool JSONBackend::GetEntryNames(StringVector &names)
 {
-    auto& obj = GetSeriesObject(true);
+    JSONValue* series = GetSeriesObject(true);
+    if (!series)
+        return false;
+    auto& obj = *series;
     if (obj.IsObject())
     {
         names.Reserve(names.Size() + obj.Size());
-        for (auto p : obj.GetObject())
+        for (const auto& p : obj.GetObject())
             names.Push(p.first_);
         return true;
     }
@@ -117,24 +148,172 @@ bool JSONBackend::SetEntryNames(const StringVector &names)
     return true;
 }
 
+bool JSONBackend::VisitEntries(const EntryVisitor &visitor)
+{
+    JSONValue* series = GetSeriesObject(true);
+    if (!series)
+        return false;
+    auto& obj = *series;
+    // Only objects have named entries. Anything else is visited as empty rather than handing the inline token out as a key.
+    if (obj.IsObject())
+    {
+        JSONObject& members = const_cast<JSONObject&>(obj.GetObject());
+        for (auto it = members.Begin(); it != members.End(); ++it)
+            visitor(it->first_, new JSONBackend(it->second_, true));
+    }
+    return true;
+}
+
+bool JSONBackend::GetRecord(RecordField *fields, unsigned count)
+{
+    bool good = true;
+    for (unsigned i = 0; i < count; ++i)
+        good &= VisitRecordField(fields[i], [this](const String& name, auto& val) { return JSONBackend::Get(name, val); });
+    return good;
+}
+
+bool JSONBackend::SetRecord(const RecordField *fields, unsigned count)
+{
+    auto& obj = *GetSeriesObject(false);
+    if (obj.IsNull())
+        obj.SetType(JSONValueType::JSON_OBJECT);
+
+    bool good = true;
+    for (unsigned i = 0; i < count; ++i)
+        good &= VisitRecordField(fields[i], [this](const String& name, auto& val) { return JSONBackend::Set(name, val); });
+    return good;
+}
+
+unsigned JSONBackend::FindEntry(const EntryAlternative *alternatives, unsigned count)
+{
+    const String* lastName = nullptr;
+    const JSONValue* holder = nullptr;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const String& name = *alternatives[i].name;
+        // Alternatives under the same name (e.g. an enum as int or string) share one lookup.
+        if (!lastName || (lastName != &name && *lastName != name))
+        {
+            holder = FindValue(name);
+            lastName = &name;
+        }
+        if (!holder)
+            continue;
+
+        switch (alternatives[i].form)
+        {
+        case ANY_FORM:
+            if (!holder->IsNull())
+                return i;
+            break;
+        case NUMBER_FORM:
+            if (holder->IsNumber() || holder->IsBool())
+                return i;
+            break;
+        case STRING_FORM:
+            if (holder->IsString())
+                return i;
+            break;
+        case GROUP_FORM:
+            if (holder->IsObject())
+                return i;
+            break;
+        case SERIES_FORM:
+            if (holder->IsArray())
+                return i;
+            break;
+        case BUFFER_FORM:
+            if (holder->IsString())
+                return i;
+            break;
+        }
+    }
+    return MISSING_ENTRY;
+}
+
 
+bool JSONBackend::Get(const String &name, PODVector<unsigned char> &val)
+{
+    const JSONValue* holder = FindValue(name);
+    return holder && holder->IsString() && Base64::Decode(holder->GetString(), val);
+}
+
+bool JSONBackend::Set(const String &name, const PODVector<unsigned char> &val)
+{
+    return SetInternal(name, Base64::Encode(val));
+}
+
+bool JSONBackend::DescribeEntry(const String &name, EntryForm &form, RecordFieldType &type)
+{
+    // Describe the stored value as is, without flattening inline value tables, so that groups holding a "value" key survive a transcode.
+    const JSONValue* series = GetSeriesObject(true);
+    if (!series)
+        return false;
+    const JSONValue& obj = *series;
+    const JSONValue* value = nullptr;
+    if (obj.IsObject() && (!IsInline(name) || obj.Size() == 1))
+    {
+        const JSONObject& members = obj.GetObject();
+        auto it = members.Find(KeyName(name));
+        if (it != members.End())
+            value = &it->second_;
+    }
+    if (!value)
+    {
+        if (!IsInline(name))
+            return false;
+        value = &obj;
+    }
+
+    type = RECORD_NONE;
+    switch (value->GetValueType())
+    {
+    case JSONValueType::JSON_NULL:
+        form = ANY_FORM;
+        break;
+    case JSONValueType::JSON_BOOL:
+        form = NUMBER_FORM;
+        type = RECORD_BOOL;
+        break;
+    case JSONValueType::JSON_NUMBER:
+        form = NUMBER_FORM;
+        switch (value->GetNumberType())
+        {
+        case JSONNumberType::JSONNT_INT: type = RECORD_SINT; break;
+        case JSONNumberType::JSONNT_UINT: type = RECORD_UINT; break;
+        default: type = RECORD_DOUBLE; break;
+        }
+        break;
+    case JSONValueType::JSON_STRING:
+        form = STRING_FORM;
+        type = RECORD_STRING;
+        break;
+    case JSONValueType::JSON_ARRAY:
+        form = SERIES_FORM;
+        break;
+    case JSONValueType::JSON_OBJECT:
+        form = GROUP_FORM;
+        break;
+    }
+    return true;
+}
 
-Urho3D::JSONValue JSONBackend::empty;
 
 Urho3D::JSONValue& JSONBackend::MakeSeriesEntryInternal(const String& name, unsigned size)
 {
-    auto& obj = GetSeriesObject(false);
-    Urho3D::JSONValue* array = nullptr;
-    if (!obj.Contains(name))
+    auto& obj = *GetSeriesObject(false);
+    const String& key = KeyName(name);
+    Urho3D::JSONValue* array = FindMember(obj, key);
+    if (!array)
     {
-        if (name == InlineName())
+        if (IsInline(name))
         {
             if (obj.IsArray())
                 array = &obj;
             else if (obj.IsNull() || (obj.IsObject() && obj.Size() == 0))
                 array = &(obj = Urho3D::JSONArray());
             else
-                array = &(obj[name] = Urho3D::JSONArray());
+                array = &(obj[key] = Urho3D::JSONArray());
         }
         else
         {
@@ -142,24 +321,27 @@ Urho3D::JSONValue& JSONBackend::MakeSeriesEntryInternal(const String& name, unsi
             if (!obj.IsObject())
             {
                 Urho3D::JSONValue oldVal = obj;
-                obj.Set(InlineName(), oldVal);
+                obj.Set(InlineText(), oldVal);
             }
 
-            array = &(obj[name] = Urho3D::JSONArray());
+            array = &(obj[key] = Urho3D::JSONArray());
         }
     }
-    else
+    else if (!array->IsArray())
     {
-        if (!obj[name].IsArray())
-        {
-            URHO3D_LOGERROR("Overwriting JSON Value with array in Archive::CreateSeriesEntry. Name="+name);
-            obj[name] = Urho3D::JSONArray();
-            throw -1;
-        }
-        array = &(obj[name]);
+        URHO3D_LOGERROR("Overwriting JSON Value with array in Archive::CreateSeriesEntry. Name="+key);
+        *array = Urho3D::JSONArray();
+        throw -1;
     }
 
-    array->Resize(Urho3D::Max(size,array->Size()));
+    if (size > array->Size())
+    {
+        // Grow geometrically so series written without a SetSeriesSize don't reallocate for every entry.
+        JSONArray& elements = const_cast<JSONArray&>(array->GetArray());
+        if (size > elements.Capacity())
+            elements.Reserve(Urho3D::Max(size, elements.Capacity() * 2));
+        elements.Resize(size);
+    }
     return *array;
 }
 
@@ -6,6 +6,8 @@
 
 #include "Utils.h"
 
+#include <functional>
+
 inline namespace Archival {
 
 class Archive;
@@ -50,19 +52,99 @@ struct Hint
     static const Hint EMPTY_HINT;
 };
 
+/// Type of a scalar field in a record passed to Backend::GetRecord/SetRecord.
+enum RecordFieldType
+{
+    RECORD_NONE,
+    RECORD_BOOL,
+    RECORD_UCHAR,
+    RECORD_SCHAR,
+    RECORD_USHORT,
+    RECORD_SSHORT,
+    RECORD_UINT,
+    RECORD_SINT,
+    RECORD_ULONGLONG,
+    RECORD_SLONGLONG,
+    RECORD_FLOAT,
+    RECORD_DOUBLE,
+    RECORD_STRING,
+};
+
+/// Maps a C++ type to its RecordFieldType. RECORD_NONE if it cannot be passed in a record.
+template<class T> struct RecordFieldTypeOf { static constexpr RecordFieldType value = RECORD_NONE; };
+template<> struct RecordFieldTypeOf<bool> { static constexpr RecordFieldType value = RECORD_BOOL; };
+template<> struct RecordFieldTypeOf<unsigned char> { static constexpr RecordFieldType value = RECORD_UCHAR; };
+template<> struct RecordFieldTypeOf<signed char> { static constexpr RecordFieldType value = RECORD_SCHAR; };
+template<> struct RecordFieldTypeOf<unsigned short> { static constexpr RecordFieldType value = RECORD_USHORT; };
+template<> struct RecordFieldTypeOf<signed short> { static constexpr RecordFieldType value = RECORD_SSHORT; };
+template<> struct RecordFieldTypeOf<unsigned int> { static constexpr RecordFieldType value = RECORD_UINT; };
+template<> struct RecordFieldTypeOf<signed int> { static constexpr RecordFieldType value = RECORD_SINT; };
+template<> struct RecordFieldTypeOf<unsigned long long> { static constexpr RecordFieldType value = RECORD_ULONGLONG; };
+template<> struct RecordFieldTypeOf<signed long long> { static constexpr RecordFieldType value = RECORD_SLONGLONG; };
+template<> struct RecordFieldTypeOf<float> { static constexpr RecordFieldType value = RECORD_FLOAT; };
+template<> struct RecordFieldTypeOf<double> { static constexpr RecordFieldType value = RECORD_DOUBLE; };
+template<> struct RecordFieldTypeOf<String> { static constexpr RecordFieldType value = RECORD_STRING; };
+
+/// One scalar field of a record passed to Backend::GetRecord/SetRecord.
+struct RecordField
+{
+    /// The name of the field. Non-owning.
+    const String* name;
+    /// StringHash of the name (case-insensitive), computed at compile time with ArchiveNameHash for ARCHIVE_FIELDS.
+    unsigned hash;
+    /// The type of the value.
+    RecordFieldType type;
+    /// Address of the value in the object being archived.
+    void* data;
+};
+
+/// Calls fn(name, value) with the record field's value cast to its actual type. For backends implementing GetRecord/SetRecord.
+template<class Fn>
+bool VisitRecordField(const RecordField& field, Fn&& fn)
+{
+    switch (field.type)
+    {
+    case RECORD_BOOL: return fn(*field.name, *static_cast<bool*>(field.data));
+    case RECORD_UCHAR: return fn(*field.name, *static_cast<unsigned char*>(field.data));
+    case RECORD_SCHAR: return fn(*field.name, *static_cast<signed char*>(field.data));
+    case RECORD_USHORT: return fn(*field.name, *static_cast<unsigned short*>(field.data));
+    case RECORD_SSHORT: return fn(*field.name, *static_cast<signed short*>(field.data));
+    case RECORD_UINT: return fn(*field.name, *static_cast<unsigned int*>(field.data));
+    case RECORD_SINT: return fn(*field.name, *static_cast<signed int*>(field.data));
+    case RECORD_ULONGLONG: return fn(*field.name, *static_cast<unsigned long long*>(field.data));
+    case RECORD_SLONGLONG: return fn(*field.name, *static_cast<signed long long*>(field.data));
+    case RECORD_FLOAT: return fn(*field.name, *static_cast<float*>(field.data));
+    case RECORD_DOUBLE: return fn(*field.name, *static_cast<double*>(field.data));
+    case RECORD_STRING: return fn(*field.name, *static_cast<String*>(field.data));
+    case RECORD_NONE: break;
+    }
+    return false;
+}
+
 /// Archival backend that actually implements the saving and loading for a specific set of types.
 class Backend
 {
-    /// Sentinel value to indicate that we are getting/setting an inline value.
+    /// Text the inline token is formatted as by backends that write keys (e.g. the JSON {"value" : VAL} form).
     String inlineValueName_{"value"};
 public:
 
     virtual ~Backend()=default;
 
-    /// Returns the current inline value sentinel string.
-    const String& InlineName() const { return inlineValueName_; }
-    /// Sets the current inline value sentinel string. Restores to default "value" with no arguments.
+    /// First character of the inline token. A control character that won't start a real name, so IsInline() is a single character comparison.
+    static constexpr char INLINE_TAG{'\x1F'};
+    /// Token to pass as the name to indicate that we are getting/setting an inline value.
+    static const String INLINE_TOKEN;
+
+    /// Returns the inline value token. Backends recognize it with IsInline() and format it as InlineText().
+    const String& InlineName() const { return INLINE_TOKEN; }
+    /// Returns the text the inline token is formatted as.
+    const String& InlineText() const { return inlineValueName_; }
+    /// Sets the text the inline token is formatted as. Restores to default "value" with no arguments.
     void ResetInlineName(const String& name = "value") { inlineValueName_ = name; }
+    /// True if the name is the inline token (or a copy of it). Never compares the full string.
+    static bool IsInline(const String& name) { return name.CString()[0] == INLINE_TAG; }
+    /// Returns the key to format the name with: InlineText() for the inline token, otherwise the name itself.
+    const String& KeyName(const String& name) const { return IsInline(name) ? inlineValueName_ : name; }
 
     /// Returns the name of the backend
     virtual const String& GetBackendName()=0;
@@ -77,6 +159,9 @@ public:
 
     /// Creates/Finds a series entry with the specified name and returns a new Backend that will use it. Returns nullptr if not found.
     virtual Backend* CreateSeriesEntry(const String& name, bool isInput)=0;
+    /// Creates/Finds the series entry with the specified name at the index directly, without creating the entries before it, and returns a new Backend that will use it. Returns nullptr if not found or unsupported.
+    /// Does not affect the entries CreateSeriesEntry goes through. Output may only support indices in order.
+    virtual Backend* CreateSeriesEntryAt(const String& name, unsigned index, bool isInput) { return nullptr; }
     /// Retrieves the size of the series with the specified name, if the series exists. Use for serializing dynamic length series.
     virtual bool GetSeriesSize(const String& name, unsigned& size)=0;
     /// Sets the size of the series with the specified name. Use for serializing dynamic length series.
@@ -88,6 +173,12 @@ public:
     /// Use for serializing dynamically named entries like a Map (with key names appropriately restricted).
     virtual bool SetEntryNames(const StringVector& names)=0;
 
+    /// Visitor for VisitEntries. Receives the entry's name and a new Backend positioned on the entry (read it with the inline name). Takes ownership of the Backend.
+    using EntryVisitor = std::function<void(const String& name, Backend* entry)>;
+    /// Calls the visitor for every entry of the group without first copying out the names, so no per-entry lookup is needed afterwards. Input only.
+    /// Returns false if the backend does not support visiting, in which case use GetEntryNames instead.
+    virtual bool VisitEntries(const EntryVisitor& visitor) { return false; }
+
 
 
     /// Estimate of how verbose an inline series is.
@@ -102,6 +193,63 @@ public:
     /// True if the Backend prefers binary data. False to prefer text data. Primarily used to determine prefered way to serialize an enum. Defaults to false as that is more human readable.
     virtual bool PrefersBinaryData() const { return false; }
 
+    /// True if extended types like Vector3 and Color are archived directly with Get/Set. Otherwise their Get/Set fail and their ArchiveValue archives them as groups of scalars.
+    virtual bool SupportsExtendedTypes() const { return false; }
+
+    ///------------------------
+    /// Lookup Functions
+
+    /// The form a stored entry takes. Lets FindEntry tell apart alternatives stored under the same name (e.g. an enum as an int or as a string).
+    enum EntryForm
+    {
+        /// Any non-null value.
+        ANY_FORM,
+        /// A number (or bool).
+        NUMBER_FORM,
+        /// A string.
+        STRING_FORM,
+        /// A group, as from CreateGroup.
+        GROUP_FORM,
+        /// A series, as from CreateSeriesEntry.
+        SERIES_FORM,
+        /// A byte buffer. Text backends store them as base64 strings, so a string matches too.
+        BUFFER_FORM,
+    };
+
+    /// One alternative to look for with FindEntry.
+    struct EntryAlternative
+    {
+        /// The name of the entry. Non-owning.
+        const String* name;
+        /// The form the entry must have to match.
+        EntryForm form;
+    };
+
+    /// Returned by FindEntry if none of the alternatives are present.
+    static constexpr unsigned MISSING_ENTRY{0xFFFFFFFF};
+    /// Returned by FindEntry if the backend cannot tell which alternative is present without trying them (e.g. a streaming or GUI backend).
+    static constexpr unsigned UNKNOWN_ENTRY{0xFFFFFFFE};
+    /// The most alternatives Archive will pass to FindEntry at once.
+    static constexpr unsigned MAX_ENTRY_ALTERNATIVES{8};
+
+    /// Returns the index of the first alternative present in the backend, MISSING_ENTRY if none are, or UNKNOWN_ENTRY if it cannot be determined up front.
+    /// Only meaningful for input. Lets fallback chains (ArchiveResult::Else) resolve in a single probe instead of a failed Get per alternative.
+    virtual unsigned FindEntry(const EntryAlternative* alternatives, unsigned count) { return UNKNOWN_ENTRY; }
+
+    /// Describes the stored entry with the name for input: its form, and for scalars the type it was stored as (RECORD_NONE for null). Lets a self-describing backend be walked without knowing the types in advance.
+    /// Returns false if the entry is missing or the backend is not self-describing.
+    virtual bool DescribeEntry(const String& name, EntryForm& form, RecordFieldType& type) { return false; }
+
+    ///------------------------
+    /// Record Functions
+
+    /// Returns true if records are archived with GetRecord/SetRecord. Otherwise their fields are archived one at a time.
+    virtual bool SupportsRecords() const { return false; }
+    /// Gets every field of a record of scalars in one call. Returns false if any field is missing, which fails the record: some fields may have been read, so it isn't retried field by field.
+    virtual bool GetRecord(RecordField* fields, unsigned count) { return false; }
+    /// Sets every field of a record of scalars in one call. Returns false if any field fails, which fails the record as for GetRecord.
+    virtual bool SetRecord(const RecordField* fields, unsigned count) { return false; }
+
     ///------------------------
     /// Control Functions
 
@@ -113,6 +261,16 @@ public:
         return condition;
     }
 
+    /// Records whether an optional entry (e.g. one equal to its default) is present. Returns true if it is, in which case it should be written on output or read on input.
+    /// On output returns present. On input defaults to asking FindEntry, so a missing entry costs a single lookup; binary backends keep a presence bitmap per group instead.
+    virtual bool WritePresence(const String& name, bool present, bool isInput)
+    {
+        if (!isInput)
+            return present;
+        EntryAlternative entry{&name, ANY_FORM};
+        return FindEntry(&entry, 1) != MISSING_ENTRY;
+    }
+
     ///------------------------
     /// Value Get/Set Functions
 
@@ -141,6 +299,9 @@ public:
     virtual bool Get(const String& name, double& val) = 0;
 
     virtual bool Get(const String& name, String& val) = 0;
+
+    /// Gets an opaque byte buffer (image data, compiled shaders, ...) in one piece. Returns false if unsupported, in which case it is archived as a series of bytes.
+    virtual bool Get(const String& name, Urho3D::PODVector<unsigned char>& val) { return false; }
 #define EXTENDED_ARCHIVE_TYPES
 #ifdef EXTENDED_ARCHIVE_TYPES
 
@@ -197,6 +358,9 @@ public:
     virtual bool Set(const String& name, const double& val) = 0;
 
     virtual bool Set(const String& name, const String& val) = 0;
+
+    /// Sets an opaque byte buffer in one piece. Returns false if unsupported, in which case it is archived as a series of bytes.
+    virtual bool Set(const String& name, const Urho3D::PODVector<unsigned char>& val) { return false; }
 #ifdef EXTENDED_ARCHIVE_TYPES
 
     /// Extended backend types should only be used if the backend has a special way of treating them.
@@ -264,6 +428,7 @@ public:
     bool GetEntryNames(StringVector &) override { return false; }
     bool SetEntryNames(const StringVector &) override { return false; }
     unsigned char InlineSeriesVerbosity() const override { return 0; }
+    unsigned FindEntry(const EntryAlternative*, unsigned) override { return MISSING_ENTRY; }
     bool Get(const String&, const std::nullptr_t&) override { return false; }
     bool Get(const String&, bool&) override { return false; }
     bool Get(const String&, unsigned char&) override { return false; }
@@ -378,52 +543,54 @@ public:
 
     /// Utility method to create an Archive with a JSONBackend from the provided value.
     static Archive MakeArchive(bool isInput, Urho3D::JSONValue& val);
+    /// Utility method to create an input Archive with a JSONBackend over a value that is never written. Input only reads, so any number of threads may read the same value at once.
+    static Archive MakeArchive(const Urho3D::JSONValue& val);
 
     Backend* CreateGroup(const String &name, bool isInput) override;
     Backend* CreateSeriesEntry(const String &name, bool isInput) override;
+    /// Any entry of the series array, on input and output.
+    Backend* CreateSeriesEntryAt(const String &name, unsigned index, bool isInput) override;
     bool GetSeriesSize(const String &name, unsigned &size) override
     {
-        auto& obj = GetSeriesObject(true);
-
-            if (name == InlineName() && obj.IsArray())
-                size = obj.Size();
-            else if (obj.Contains(name))
-                size = obj[name].Size();
-            else
-                return false;
+        JSONValue* obj = GetSeriesObject(true);
+        if (!obj)
+            return false;
 
+        if (IsInline(name) && obj->IsArray())
+            size = obj->Size();
+        else if (JSONValue* array = FindMember(*obj, KeyName(name)))
+            size = array->Size();
+        else
+            return false;
         return true;
     }
     bool SetSeriesSize(const String &name, const unsigned &size) override;
     bool GetEntryNames(StringVector &names) override;
     bool SetEntryNames(const StringVector &names) override;
+    bool VisitEntries(const EntryVisitor& visitor) override;
     unsigned char InlineSeriesVerbosity() const override { return 10; }
+    bool SupportsRecords() const override { return true; }
+    bool GetRecord(RecordField* fields, unsigned count) override;
+    bool SetRecord(const RecordField* fields, unsigned count) override;
+    unsigned FindEntry(const EntryAlternative* alternatives, unsigned count) override;
+    bool DescribeEntry(const String &name, EntryForm &form, RecordFieldType &type) override;
 
     bool Get(const String &name, const std::nullptr_t &) override
     {
-        auto& obj = GetSeriesObject(true);
-        if (obj.IsObject() && obj.Contains(name))
-        {
-            auto holder = obj[name];
-            // flatten inline value tables.
-            while (holder.IsObject() && holder.Contains(InlineName()))
-                holder = obj[InlineName()];
-            return holder.IsNull();
-        }
-        else if (name == InlineName())
-            return obj.IsNull();
+        if (const JSONValue* holder = FindValue(name))
+            return holder->IsNull();
         return false;
     }
     bool Set(const String &name, const std::nullptr_t &) override
     {
         auto& obj = (object_.IsArray() ? object_[seriesEntry_] : object_);
-        if (name == InlineName())
+        if (IsInline(name))
         {
             // need the null check anyways to avoid the else branch
             if (obj.IsNull() || (obj.IsObject() && obj.Size() == 0))
                 obj.SetType(JSONValueType::JSON_NULL);
             else
-                obj[name].SetType(JSONValueType::JSON_NULL);
+                obj[InlineText()].SetType(JSONValueType::JSON_NULL);
         }
         else
         {
@@ -431,7 +598,7 @@ public:
             if (!obj.IsObject())
             {
                 Urho3D::JSONValue oldVal = obj;
-                obj.Set(InlineName(), oldVal);
+                obj.Set(InlineText(), oldVal);
             }
 
             obj[name].SetType(JSONValueType::JSON_NULL);
@@ -488,6 +655,8 @@ public:
     bool Get(const String &name, float &val) override { return GetInternal(name, val); }
     bool Get(const String &name, double &val) override { return GetInternal(name, val); }
     bool Get(const String &name, String &val) override { return GetInternal(name, val); }
+    /// Buffers are stored as base64 strings.
+    bool Get(const String &name, Urho3D::PODVector<unsigned char> &val) override;
 
     bool Set(const String &name, const bool &val) override { return SetInternal(name, val); }
     bool Set(const String &name, const unsigned char &val) override { return SetInternal(name, val); }
@@ -509,40 +678,74 @@ public:
     bool Set(const String &name, const float &val) override { return SetInternal(name, val); }
     bool Set(const String &name, const double &val) override { return SetInternal(name, val); }
     bool Set(const String &name, const String &val) override { return SetInternal(name, val); }
+    bool Set(const String &name, const Urho3D::PODVector<unsigned char> &val) override;
 
 //    bool HintBounds(Urho3D::Variant min, Urho3D::Variant max) override {}
 //    bool ClearHints() override {}
 
 
-    Urho3D::JSONValue& GetSeriesObject(bool isInput)
+    /// Returns the value the backend reads or writes: its object, or its entry of the series array. On input, returns null for an entry past the end of the series, and input never writes through the result. Never null on output.
+    Urho3D::JSONValue* GetSeriesObject(bool isInput)
     {
         if (seriesEntry_ != INVALID_SERIES_ENTRY)
         {
             assert(object_.IsArray());
-            if (!isInput || seriesEntry_ < object_.Size())
-                return object_[seriesEntry_];
-            else
-                return empty;
+            if (!isInput)
+                return &object_[seriesEntry_];
+            // Read through the const array so that input never writes to the document.
+            const Urho3D::JSONArray& array = object_.GetArray();
+            return seriesEntry_ < array.Size() ? const_cast<JSONValue*>(&array[seriesEntry_]) : nullptr;
         }
-        return object_;
+        return &object_;
+    }
+
+    /// Returns the member of the JSON value with the specified key, or nullptr if it is not an object or has no such member. Takes a single hash lookup.
+    static JSONValue* FindMember(JSONValue& obj, const String& key)
+    {
+        if (!obj.IsObject())
+            return nullptr;
+        JSONObject& members = const_cast<JSONObject&>(obj.GetObject());
+        auto it = members.Find(key);
+        return it != members.End() ? &it->second_ : nullptr;
     }
 
 private:
 
-    template<class T>
-    bool GetInternal(const String& name, T& val)
+    /// Finds the value with the specified name for input with a single lookup, flattening inline value tables. Returns nullptr if not present.
+    const JSONValue* FindValue(const String& name)
     {
-        auto& obj = GetSeriesObject(true);
-        if (obj.IsObject() && obj.Contains(name))
+        const JSONValue* series = GetSeriesObject(true);
+        if (!series)
+            return nullptr;
+        const JSONValue& obj = *series;
+        const JSONValue* holder = nullptr;
+        if (obj.IsObject())
+        {
+            const JSONObject& members = obj.GetObject();
+            auto it = members.Find(KeyName(name));
+            if (it != members.End())
+                holder = &it->second_;
+        }
+        if (!holder)
+            return IsInline(name) ? &obj : nullptr;
+
+        // flatten inline value tables.
+        while (holder->IsObject())
         {
-            auto holder = obj[name];
-            // flatten inline value tables.
-            while (holder.IsObject() && holder.Contains(InlineName()))
-                holder = obj[InlineName()];
-            return Urho3D::GetJSON<T>(holder, val);
+            const JSONObject& members = holder->GetObject();
+            auto it = members.Find(InlineText());
+            if (it == members.End())
+                break;
+            holder = &it->second_;
         }
-        else if (name == InlineName())
-            return Urho3D::GetJSON<T>(obj, val);
+        return holder;
+    }
+
+    template<class T>
+    bool GetInternal(const String& name, T& val)
+    {
+        if (const JSONValue* holder = FindValue(name))
+            return Urho3D::GetJSON<T>(*holder, val);
         return false;
     }
 
@@ -550,12 +753,12 @@ private:
     inline bool SetInternal(const String& name, const T& val)
     {
         auto& obj = (object_.IsArray() ? object_[seriesEntry_] : object_);
-        if (name == InlineName())
+        if (IsInline(name))
         {
             if (obj.IsNull() || (obj.IsObject() && obj.Size() == 0))
                 Detail::SetJSON(obj, val); // obj = val;
             else
-                Detail::SetJSON(obj[name], val); // obj[name] = val;
+                Detail::SetJSON(obj[InlineText()], val); // obj[name] = val;
         }
         else
         {
@@ -563,7 +766,7 @@ private:
             if (!obj.IsObject())
             {
                 Urho3D::JSONValue oldVal = obj;
-                obj.Set(InlineName(), oldVal);
+                obj.Set(InlineText(), oldVal);
             }
 
             Detail::SetJSON(obj[name], val); // obj[name] = val;
@@ -575,8 +778,9 @@ private:
     Urho3D::HashMap<String, unsigned> entries_;
     static constexpr unsigned INVALID_SERIES_ENTRY{0xFFFFFFFF};
     unsigned seriesEntry_{INVALID_SERIES_ENTRY};
-    static Urho3D::JSONValue empty;
 
+    /// Creates the backend of the series entry with the index.
+    Backend* MakeSeriesEntry(const String &name, unsigned idx, bool isInput);
     /// Get/Create and return a reference to a JSONValue Array with the specified size. Must be an output operation.
     JSONValue &MakeSeriesEntryInternal(const String &name, unsigned size);
 };
@@ -584,8 +788,6 @@ private:
 
 ///TODO: XML Backend. Inline serialization will be <parent>Value</parent> maybe Inline series has to be faked entirely though
 
-///TODO: Interface to iterate arbitrary named archive entries (for building a VariantMap, for example0
-
 
 }
 
@@ -0,0 +1,63 @@
+#include "ArchiveImage.h"
+
+#include <cstring>
+
+inline namespace Archival {
+
+namespace {
+
+/// Appends a field value to an image: scalars are packed into the value bytes, Strings are kept aside.
+struct SlotCapture
+{
+    Urho3D::PODVector<unsigned char>& values_;
+    Urho3D::Vector<String>& strings_;
+    unsigned size_{};
+    unsigned value_{};
+
+    template<class T>
+    bool operator ()(const String&, const T& value)
+    {
+        size_ = sizeof(T);
+        value_ = values_.Size();
+        values_.Resize(value_ + sizeof(T));
+        memcpy(&values_[value_], &value, sizeof(T));
+        return true;
+    }
+
+    bool operator ()(const String&, const String& value)
+    {
+        size_ = 0;
+        value_ = strings_.Size();
+        strings_.Push(value);
+        return true;
+    }
+};
+
+}
+
+void ArchiveImage::CaptureSlots(const ArchivePlan& plan, const void* object)
+{
+    auto* base = static_cast<unsigned char*>(const_cast<void*>(object));
+    for (const ArchivePlan::Op& op : plan.GetOps())
+    {
+        if (op.kind != ArchivePlan::OP_VALUE)
+            continue;
+        SlotCapture capture{values_, strings_};
+        if (Detail::VisitRecordField(Detail::RecordField{&op.name, op.hash, op.type, base + op.offset}, capture))
+            slots_.Push(Slot{op.offset, capture.size_, capture.value_});
+    }
+}
+
+void ArchiveImage::ReplaySlots(void* object) const
+{
+    auto* base = static_cast<unsigned char*>(object);
+    for (const Slot& slot : slots_)
+    {
+        if (slot.size_)
+            memcpy(base + slot.offset_, &values_[slot.value_], slot.size_);
+        else
+            *reinterpret_cast<String*>(base + slot.offset_) = strings_[slot.value_];
+    }
+}
+
+}
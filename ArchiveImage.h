@@ -0,0 +1,147 @@
+#pragma once
+
+#include <Urho3D/Container/Pair.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+#include "ArchivePlan.h"
+#include "BinaryBackend.h"
+
+inline namespace Archival {
+
+/// A loaded value decoded once into a compact image that can be replayed into any number of new objects of the same type, without the source archive.
+/// Fixed-shape types are captured as field slots (offset and type, resolved by the ArchivePlan of the type) with their values, and replayed by copying each value straight into its slot.
+/// Other types are captured in the positional binary layout and replayed through their ArchiveValue, which skips name lookups and text parsing.
+class ArchiveImage
+{
+public:
+    /// Captures the value archived under the name.
+    template<class T>
+    static std::shared_ptr<const ArchiveImage> Capture(const String& name, T& value)
+    {
+        std::shared_ptr<ArchiveImage> image(new ArchiveImage());
+        // Slots only need the offsets of the scalars, so the plan is recorded for no backend in particular.
+        std::shared_ptr<ArchivePlan> plan = ArchivePlanCache<T>::Get(name, value, ArchivePlan::BackendCapabilities());
+        if (plan->IsValid())
+            image->CaptureSlots(*plan, &value);
+        else
+        {
+            Urho3D::VectorBuffer binary;
+            if (!Detail::BinaryBackend::MakeArchive(static_cast<Urho3D::Serializer&>(binary)).Serialize(name, value))
+                return nullptr;
+            image->name_ = name;
+            image->binary_ = binary.GetBuffer();
+        }
+        return image;
+    }
+
+    /// Replays the image into the value, which should be newly constructed. The value must be of the type the image was captured from.
+    template<class T>
+    bool Replay(T& value) const
+    {
+        if (!binary_.Empty())
+        {
+            Urho3D::MemoryBuffer source(binary_);
+            return Detail::BinaryBackend::MakeArchive(static_cast<Urho3D::Deserializer&>(source)).Serialize(name_, value);
+        }
+        ReplaySlots(&value);
+        return true;
+    }
+
+    /// Returns true if the image is replayed slot by slot rather than through the binary layout.
+    bool HasSlots() const { return binary_.Empty(); }
+
+private:
+    /// A value of the image and where it goes in the object.
+    struct Slot
+    {
+        /// Byte offset of the field in the object.
+        unsigned offset_;
+        /// Size of a scalar field in bytes, 0 for a String.
+        unsigned size_;
+        /// Byte offset of the value in values_, or its index in strings_ for a String.
+        unsigned value_;
+    };
+
+    /// Captures the value of every field of the plan from the object.
+    void CaptureSlots(const ArchivePlan& plan, const void* object);
+    /// Copies every captured value into its field of the object.
+    void ReplaySlots(void* object) const;
+
+    /// Field slots in plan order.
+    Urho3D::PODVector<Slot> slots_;
+    /// Scalar values, packed.
+    Urho3D::PODVector<unsigned char> values_;
+    /// String values.
+    Urho3D::Vector<String> strings_;
+    /// Name the value was archived under, for binary images.
+    String name_;
+    /// The value in the positional binary layout, for types without a valid plan.
+    Urho3D::PODVector<unsigned char> binary_;
+};
+
+/// Process-wide cache of the images of values of type T loaded from each source (file or resource name) under each name, so that loading the same prefab again replays its image instead of reading and parsing the archive.
+/// Images are handed out as std::shared_ptr so that an invalidated image stays alive for threads still replaying it.
+template<class T>
+class ArchiveInstanceCache
+{
+public:
+    /// Loads the value archived under the name from the source. The first load of a source and name reads it from the input Archive returned by open() and captures its image; later loads replay the image. Thread safe.
+    template<class Open>
+    static bool Instantiate(const String& source, const String& name, T& value, Open&& open)
+    {
+        const Key key(source, name);
+        if (std::shared_ptr<const ArchiveImage> image = Find(key))
+            return image->Replay(value);
+
+        {
+            Archive input = open();
+            if (!input.IsInput() || !input.Serialize(name, value))
+                return false;
+        }
+        // Capture from a copy, so that recording the plan doesn't touch the caller's value.
+        T captured = value;
+        if (std::shared_ptr<const ArchiveImage> image = ArchiveImage::Capture(name, captured))
+        {
+            std::lock_guard<std::mutex> lock(Mutex());
+            Images()[key] = image;
+        }
+        return true;
+    }
+
+    /// Drops the images of the source under every name, for example when its file has changed, or of every source if it is empty.
+    static void Invalidate(const String& source = String::EMPTY)
+    {
+        std::lock_guard<std::mutex> lock(Mutex());
+        if (source.Empty())
+        {
+            Images().Clear();
+            return;
+        }
+        for (auto it = Images().Begin(); it != Images().End();)
+        {
+            if (it->first_.first_ == source)
+                it = Images().Erase(it);
+            else
+                ++it;
+        }
+    }
+
+private:
+    /// The source and name an image was loaded from.
+    using Key = Urho3D::Pair<String, String>;
+    using ImageMap = Urho3D::HashMap<Key, std::shared_ptr<const ArchiveImage>>;
+
+    /// Returns the image of the source and name, or null.
+    static std::shared_ptr<const ArchiveImage> Find(const Key& key)
+    {
+        std::lock_guard<std::mutex> lock(Mutex());
+        auto it = Images().Find(key);
+        return it != Images().End() ? it->second_ : nullptr;
+    }
+
+    static ImageMap& Images() { static ImageMap images; return images; }
+    static std::mutex& Mutex() { static std::mutex mutex; return mutex; }
+};
+
+}
@@ -0,0 +1,245 @@
+#include "ArchivePlan.h"
+
+#include <Urho3D/Math/StringHash.h>
+
+inline namespace Archival {
+
+namespace Detail {
+
+/// Output backend that records every operation of a traversal into an ArchivePlan, resolving each scalar to its offset in the recorded object.
+class PlanRecordingBackend: public Backend
+{
+public:
+    /// Construct to record into the plan at the specified depth (0 for the root), reporting the backend capabilities.
+    PlanRecordingBackend(ArchivePlan& plan, unsigned depth, const ArchivePlan::BackendCapabilities& backend): plan_(plan), depth_(depth), backend_(backend) {}
+
+    /// Destruct. Closes the group or series entry this backend was created for.
+    ~PlanRecordingBackend() override
+    {
+        if (!depth_)
+            return;
+        if (plan_.openDepth_ != depth_)
+            plan_.valid_ = false;
+        else
+        {
+            plan_.ops_.Push({ArchivePlan::OP_END, String::EMPTY, 0, RECORD_NONE, 0});
+            --plan_.openDepth_;
+        }
+    }
+
+    const String& GetBackendName() override { return backend_.name; }
+    bool PrefersBinaryData() const override { return backend_.prefersBinary; }
+    bool SupportsExtendedTypes() const override { return backend_.extendedTypes; }
+
+    Backend* CreateGroup(const String &name, bool isInput) override { return Open(ArchivePlan::OP_GROUP, name, isInput); }
+    Backend* CreateSeriesEntry(const String &name, bool isInput) override { return Open(ArchivePlan::OP_SERIES_ENTRY, name, isInput); }
+
+    /// Anything dynamic can't be planned.
+    bool GetSeriesSize(const String &, unsigned &) override { return Fail(); }
+    bool SetSeriesSize(const String &, const unsigned &) override { return Fail(); }
+    bool GetEntryNames(StringVector &) override { return Fail(); }
+    bool SetEntryNames(const StringVector &) override { return Fail(); }
+    bool WriteConditional(bool, bool) override { return Fail(); }
+    bool WritePresence(const String&, bool, bool) override { return Fail(); }
+    bool AddHint(const Hint &) override { return Fail(); }
+    using Backend::AddHint;
+
+    unsigned char InlineSeriesVerbosity() const override { return 0; }
+    /// Output always uses the first alternative.
+    unsigned FindEntry(const EntryAlternative*, unsigned count) override { return count ? 0 : MISSING_ENTRY; }
+
+    bool Get(const String &, const std::nullptr_t &) override { return Fail(); }
+    bool Get(const String &, bool &) override { return Fail(); }
+    bool Get(const String &, unsigned char &) override { return Fail(); }
+    bool Get(const String &, signed char &) override { return Fail(); }
+    bool Get(const String &, unsigned short &) override { return Fail(); }
+    bool Get(const String &, signed short &) override { return Fail(); }
+    bool Get(const String &, unsigned int &) override { return Fail(); }
+    bool Get(const String &, signed int &) override { return Fail(); }
+    bool Get(const String &, unsigned long long &) override { return Fail(); }
+    bool Get(const String &, signed long long &) override { return Fail(); }
+    bool Get(const String &, float &) override { return Fail(); }
+    bool Get(const String &, double &) override { return Fail(); }
+    bool Get(const String &, String &) override { return Fail(); }
+
+    bool Set(const String &, const std::nullptr_t &) override { return Fail(); }
+    bool Set(const String &name, const bool &val) override { return Record(name, val); }
+    bool Set(const String &name, const unsigned char &val) override { return Record(name, val); }
+    bool Set(const String &name, const signed char &val) override { return Record(name, val); }
+    bool Set(const String &name, const unsigned short &val) override { return Record(name, val); }
+    bool Set(const String &name, const signed short &val) override { return Record(name, val); }
+    bool Set(const String &name, const unsigned int &val) override { return Record(name, val); }
+    bool Set(const String &name, const signed int &val) override { return Record(name, val); }
+    bool Set(const String &name, const unsigned long long &val) override { return Record(name, val); }
+    bool Set(const String &name, const signed long long &val) override { return Record(name, val); }
+    bool Set(const String &name, const float &val) override { return Record(name, val); }
+    bool Set(const String &name, const double &val) override { return Record(name, val); }
+    bool Set(const String &name, const String &val) override { return Record(name, val); }
+
+    /// Extended types can't be planned. Without them they fail like on the backend, so that their ArchiveValue falls back to scalars.
+    bool Set(const String &, const Urho3D::IntVector2 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::IntVector3 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Vector2 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Vector3 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Vector4 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Quaternion &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Color &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Matrix3 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Matrix3x4 &) override { return Extended(); }
+    bool Set(const String &, const Urho3D::Matrix4 &) override { return Extended(); }
+
+private:
+    /// Marks the plan invalid and fails the operation.
+    bool Fail()
+    {
+        plan_.valid_ = false;
+        return false;
+    }
+
+    /// Fails an extended type, which invalidates the plan if the backend would have archived it directly.
+    bool Extended() { return backend_.extendedTypes ? Fail() : false; }
+
+    /// True if this backend is the innermost open one, so operations on it keep the plan flat.
+    bool IsCurrent() const { return plan_.openDepth_ == depth_; }
+
+    /// Records a group or series entry and returns the backend for its contents.
+    Backend* Open(ArchivePlan::OpKind kind, const String& name, bool isInput)
+    {
+        if (isInput || !IsCurrent())
+        {
+            Fail();
+            return nullptr;
+        }
+        plan_.ops_.Push({kind, name, StringHash(name).Value(), RECORD_NONE, 0});
+        return new PlanRecordingBackend(plan_, ++plan_.openDepth_, backend_);
+    }
+
+    /// Records a scalar, provided it lives inside the recorded object.
+    template<class T>
+    bool Record(const String& name, const T& val)
+    {
+        const unsigned char* address = reinterpret_cast<const unsigned char*>(&val);
+        if (!IsCurrent() || address < plan_.recordBase_ || address + sizeof(T) > plan_.recordBase_ + plan_.recordSize_)
+            return Fail();
+        plan_.ops_.Push({ArchivePlan::OP_VALUE, name, StringHash(name).Value(), RecordFieldTypeOf<T>::value, static_cast<unsigned>(address - plan_.recordBase_)});
+        return true;
+    }
+
+    /// The plan being recorded.
+    ArchivePlan& plan_;
+    /// Depth of the group or series entry this backend records, 0 for the root.
+    unsigned depth_;
+    /// Capabilities reported in place of the backend the plan is executed against.
+    ArchivePlan::BackendCapabilities backend_;
+};
+
+}
+
+Detail::Backend *ArchivePlan::CreateRecorder(const void *object, unsigned size, const BackendCapabilities& backend)
+{
+    recordBase_ = static_cast<const unsigned char*>(object);
+    recordSize_ = size;
+    return new Detail::PlanRecordingBackend(*this, 0, backend);
+}
+
+void ArchivePlan::FinishRecording()
+{
+    recordBase_ = nullptr;
+    recordSize_ = 0;
+    if (openDepth_ || ops_.Empty())
+        valid_ = false;
+    if (!valid_)
+    {
+        ops_.Clear();
+        return;
+    }
+
+    // Exactly one outermost operation, so that it can be renamed by Execute.
+    unsigned depth = 0;
+    unsigned roots = 0;
+    for (const Op& op : ops_)
+    {
+        if (op.kind == OP_END)
+            --depth;
+        else
+        {
+            if (!depth)
+                ++roots;
+            if (op.kind != OP_VALUE)
+                ++depth;
+        }
+    }
+    if (roots != 1)
+    {
+        valid_ = false;
+        ops_.Clear();
+    }
+}
+
+bool ArchivePlan::Execute(Archive &ar, const String &name, void *object) const
+{
+    if (!valid_)
+        return false;
+    unsigned i = 0;
+    return ExecuteRange(ar, i, static_cast<unsigned char*>(object), &name);
+}
+
+bool ArchivePlan::ExecuteRange(Archive &ar, unsigned &i, unsigned char *object, const String *rootName) const
+{
+    static constexpr unsigned MAX_RECORD{32};
+
+    bool good = true;
+    while (i < ops_.Size())
+    {
+        const Op& op = ops_[i];
+        const String& opName = (i == 0 && rootName) ? *rootName : op.name;
+        switch (op.kind)
+        {
+        case OP_END:
+            ++i;
+            return good;
+        case OP_GROUP:
+        {
+            Archive child = ar.CreateGroup(opName);
+            ++i;
+            good &= ExecuteRange(child, i, object, nullptr);
+            break;
+        }
+        case OP_SERIES_ENTRY:
+        {
+            Archive child = ar.CreateSeriesEntry(opName);
+            ++i;
+            good &= ExecuteRange(child, i, object, nullptr);
+            break;
+        }
+        case OP_VALUE:
+        {
+            // Hand the run of scalars to the backend as one record.
+            Detail::RecordField record[MAX_RECORD];
+            unsigned count = 0;
+            for (; i < ops_.Size() && ops_[i].kind == OP_VALUE && count < MAX_RECORD; ++i, ++count)
+            {
+                const Op& value = ops_[i];
+                record[count] = {i == 0 && rootName ? rootName : &value.name, value.hash, value.type, object + value.offset};
+            }
+
+            // A failed record may have consumed some of its fields already, so it is never retried field by field.
+            Detail::Backend& backend = ar.GetBackend();
+            if (backend.SupportsRecords())
+            {
+                good &= ar.IsInput() ? backend.GetRecord(record, count) : backend.SetRecord(record, count);
+                break;
+            }
+            for (unsigned f = 0; f < count; ++f)
+                good &= Detail::VisitRecordField(record[f], [&](const String& fieldName, auto& val)
+                {
+                    return ar.IsInput() ? backend.Get(fieldName, val) : backend.Set(fieldName, val);
+                });
+            break;
+        }
+        }
+    }
+    return good;
+}
+
+}
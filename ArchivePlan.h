@@ -0,0 +1,177 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include <Urho3D/Container/Pair.h>
+
+#include "Archive.h"
+
+inline namespace Archival {
+
+namespace Detail {
+class PlanRecordingBackend;
+}
+
+/// A flat recording of the groups, series entries and scalar fields an ArchiveValue traversal produces for a type, with each scalar resolved to its byte offset in the object.
+/// Replaying it skips the ArchiveValue code, name fallbacks and GetSet holders entirely and hands each run of scalars to the backend as one record.
+/// Only types with a fixed shape can be planned: any conditional, dynamic series, entry names, hints or values not stored directly in the object make the recording invalid.
+/// A type whose ArchiveValue takes a different path depending on the value (without WriteConditional) must declare it with an ArchiveShape member, see HasArchiveShape.
+class ArchivePlan
+{
+public:
+    /// The kind of a recorded operation.
+    enum OpKind
+    {
+        /// Create a group with the name. Followed by its contents and an OP_END.
+        OP_GROUP,
+        /// Create a series entry with the name. Followed by its contents and an OP_END.
+        OP_SERIES_ENTRY,
+        /// Close the innermost group or series entry.
+        OP_END,
+        /// Get/Set a scalar with the name at the offset.
+        OP_VALUE,
+    };
+
+    /// One recorded operation.
+    struct Op
+    {
+        /// The kind of operation.
+        OpKind kind;
+        /// The name passed to the backend.
+        String name;
+        /// StringHash of the name, the same as ArchiveNameHash gives for ARCHIVE_FIELDS.
+        unsigned hash;
+        /// Type of the value for OP_VALUE.
+        Detail::RecordFieldType type;
+        /// Byte offset of the value in the object for OP_VALUE.
+        unsigned offset;
+    };
+
+    /// The capabilities of a backend that change the operations an ArchiveValue traversal produces. A plan is recorded by a recorder reporting the capabilities of the backend it is executed against.
+    struct BackendCapabilities
+    {
+        /// See Backend::GetBackendName.
+        String name;
+        /// See Backend::SupportsExtendedTypes.
+        bool extendedTypes{};
+        /// See Backend::PrefersBinaryData.
+        bool prefersBinary{};
+
+        /// Returns the capabilities of the backend.
+        static BackendCapabilities Of(Detail::Backend& backend) { return {backend.GetBackendName(), backend.SupportsExtendedTypes(), backend.PrefersBinaryData()}; }
+
+        bool operator ==(const BackendCapabilities& rhs) const { return name == rhs.name && extendedTypes == rhs.extendedTypes && prefersBinary == rhs.prefersBinary; }
+        /// Returns the hash for HashMap keys.
+        unsigned ToHash() const { return name.ToHash() * 4 + extendedTypes * 2 + prefersBinary; }
+    };
+
+    /// Records the plan by running the output traversal of the value on a recorder with the backend capabilities. The result is invalid if the type does not have a fixed shape.
+    template<class T>
+    static std::shared_ptr<ArchivePlan> Record(const String& name, T& value, const BackendCapabilities& backend)
+    {
+        std::shared_ptr<ArchivePlan> plan(new ArchivePlan());
+        {
+            Archive recorder(false, plan->CreateRecorder(&value, sizeof(T), backend));
+            recorder.Serialize(name, value);
+        }
+        plan->FinishRecording();
+        return plan;
+    }
+
+    /// Returns true if the recording succeeded and the plan can be executed.
+    bool IsValid() const { return valid_; }
+    /// Returns the recorded operations.
+    const Urho3D::Vector<Op>& GetOps() const { return ops_; }
+
+    /// Executes the plan against the archive for the object, using the name in place of the recorded one for the outermost operation.
+    /// Returns false if any operation failed (e.g. the input was stored in a different layout).
+    bool Execute(Archive& ar, const String& name, void* object) const;
+
+private:
+    friend class Detail::PlanRecordingBackend;
+
+    /// Creates the backend that records into this plan, reporting the backend capabilities.
+    Detail::Backend* CreateRecorder(const void* object, unsigned size, const BackendCapabilities& backend);
+    /// Validates the recording once the traversal has finished.
+    void FinishRecording();
+
+    /// Executes the operations from index i up to the matching OP_END (or the end of the plan).
+    bool ExecuteRange(Archive& ar, unsigned& i, unsigned char* object, const String* rootName) const;
+
+    /// The recorded operations.
+    Urho3D::Vector<Op> ops_;
+    /// Start of the object being recorded.
+    const unsigned char* recordBase_{};
+    /// Size of the object being recorded.
+    unsigned recordSize_{};
+    /// Number of groups/series entries currently open while recording.
+    unsigned openDepth_{};
+    /// False if anything recorded could not be planned.
+    bool valid_{true};
+};
+
+/// True if the type has an `unsigned ArchiveShape() const` member, returning a fingerprint of the shape its ArchiveValue produces for the value: for example which of its optional parts are archived.
+/// Plans of such a type are recorded and looked up per shape, so a value is never archived with the plan of another shape. Its values can't be planned on input, as their shape is only known once read.
+template<class T, class = void>
+struct HasArchiveShape: std::false_type {};
+template<class T>
+struct HasArchiveShape<T, decltype(void(std::declval<const T&>().ArchiveShape()))>: std::true_type {};
+
+/// Process-wide cache of the plans for a type, one per shape (see HasArchiveShape) and backend capabilities. The first SerializePlanned of a shape on such a backend records its plan; a failed output replay invalidates them so that they are recorded again.
+/// Plans are handed out as std::shared_ptr so that an invalidated plan stays alive for threads still executing it.
+template<class T>
+class ArchivePlanCache
+{
+public:
+    /// Returns the cached plan for the shape of the value on a backend with the capabilities, recording it from the value if there is none yet.
+    static std::shared_ptr<ArchivePlan> Get(const String& name, T& value, const ArchivePlan::BackendCapabilities& backend)
+    {
+        const PlanKey key(ShapeOf(value, HasArchiveShape<T>()), backend);
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::shared_ptr<ArchivePlan>& plan = Plans()[key];
+        if (!plan)
+            plan = ArchivePlan::Record(name, value, backend);
+        return plan;
+    }
+
+    /// Drops the cached plans so that the next use records them again.
+    static void Invalidate()
+    {
+        std::lock_guard<std::mutex> lock(Mutex());
+        Plans().Clear();
+    }
+
+private:
+    /// Shape of the value and capabilities of the backend a plan was recorded for.
+    using PlanKey = Urho3D::Pair<unsigned, ArchivePlan::BackendCapabilities>;
+
+    static unsigned ShapeOf(const T& value, std::true_type) { return value.ArchiveShape(); }
+    static unsigned ShapeOf(const T&, std::false_type) { return 0; }
+
+    static Urho3D::HashMap<PlanKey, std::shared_ptr<ArchivePlan>>& Plans() { static Urho3D::HashMap<PlanKey, std::shared_ptr<ArchivePlan>> plans; return plans; }
+    static std::mutex& Mutex() { static std::mutex mutex; return mutex; }
+};
+
+/// Archives the value through the cached plan for its type (and shape) when it has one, otherwise through the normal ArchiveValue traversal.
+/// The choice is made before anything is archived: a failed replay has already read or written part of the value, so it fails rather than archiving the value again.
+/// Intended for fixed-shape types archived many times per frame, like network snapshots and inspector panels.
+template<class T>
+bool SerializePlanned(Archive& ar, const String& name, T& value)
+{
+    // The shape of a value being read is only known once it has been read.
+    if (ar.IsInput() && HasArchiveShape<T>::value)
+        return ar.Serialize(name, value);
+
+    std::shared_ptr<ArchivePlan> plan = ArchivePlanCache<T>::Get(name, value, ArchivePlan::BackendCapabilities::Of(ar.GetBackend()));
+    if (!plan->IsValid())
+        return ar.Serialize(name, value);
+    if (plan->Execute(ar, name, &value))
+        return true;
+    // The output no longer matches the recording, so record it again next time.
+    if (!ar.IsInput())
+        ArchivePlanCache<T>::Invalidate();
+    return false;
+}
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "Archive.h"
+
+inline namespace Archival {
+
+/// Writes a series of unbounded length to an output Archive without holding it in memory. Elements are pushed one at a time or in blocks, and written out a block at a time.
+/// The series is stored as a series of blocks under its name, each a sized inline series of elements, ended by an empty block. Only SeriesReader reads it back.
+/// In the positional binary layout the stream is only bounded at the root or inside series entries, as groups buffer their contents until they close unless written with the tally of a counting pass.
+template<class T>
+class SeriesWriter
+{
+public:
+    /// Default number of elements written per block.
+    static constexpr unsigned DEFAULT_BLOCK_SIZE{4096};
+
+    /// Construct to write the series with the name to the archive, which must outlive the writer.
+    SeriesWriter(Archive& ar, const String& name, unsigned blockSize = DEFAULT_BLOCK_SIZE): ar_(ar), name_(name), blockSize_(Urho3D::Max(blockSize, 1u)), good_(!ar.IsInput())
+    {
+        block_.Reserve(blockSize_);
+    }
+    /// Destruct. Closes the series if Close wasn't called.
+    ~SeriesWriter() { Close(); }
+
+    /// Pushes an element. Returns false if writing has failed.
+    bool Push(const T& value)
+    {
+        block_.Push(value);
+        return block_.Size() < blockSize_ ? good_ : Flush();
+    }
+    /// Pushes a block of elements. Returns false if writing has failed.
+    bool Push(const T* values, unsigned count)
+    {
+        for (unsigned i = 0; i < count; ++i)
+            Push(values[i]);
+        return good_;
+    }
+
+    /// Writes the elements still pushed and the end of the series. Returns false if writing has failed at any point.
+    bool Close()
+    {
+        if (closed_)
+            return good_;
+        if (!block_.Empty())
+            Flush();
+        // The empty block ends the series.
+        Flush();
+        closed_ = true;
+        return good_;
+    }
+
+    /// Returns the number of elements pushed so far.
+    unsigned long long GetCount() const { return count_ + block_.Size(); }
+    /// Returns false if writing has failed.
+    bool IsGood() const { return good_; }
+
+private:
+    /// Writes the pushed elements as one block.
+    bool Flush()
+    {
+        if (good_)
+        {
+            Archive entry = ar_.CreateSeriesEntry(name_);
+            const String& inlineName = entry.GetBackend().InlineName();
+            unsigned size = block_.Size();
+            good_ = entry.SerializeSeriesSize(inlineName, size);
+            for (unsigned i = 0; good_ && i < size; ++i)
+                good_ = static_cast<bool>(entry.CreateSeriesEntry(inlineName).SerializeInline(block_[i]));
+        }
+        count_ += block_.Size();
+        block_.Clear();
+        return good_;
+    }
+
+    /// The archive written to.
+    Archive& ar_;
+    /// Name of the series.
+    String name_;
+    /// Elements per block.
+    unsigned blockSize_;
+    /// Elements pushed since the last block was written.
+    Urho3D::Vector<T> block_;
+    /// Elements written so far.
+    unsigned long long count_{};
+    /// False once writing has failed.
+    bool good_;
+    /// True once the end of the series has been written.
+    bool closed_{};
+};
+
+/// Reads a series written by SeriesWriter from an input Archive in batches of any size, independent of the blocks it was written in. Only the block being read is open at a time.
+template<class T>
+class SeriesReader
+{
+public:
+    /// Construct to read the series with the name from the archive, which must outlive the reader.
+    SeriesReader(Archive& ar, const String& name): ar_(ar), name_(name), good_(ar.IsInput()), end_(!good_) {}
+
+    /// Reads the next element. Returns false at the end of the series or if reading has failed, check IsGood to tell apart.
+    bool Pull(T& value)
+    {
+        if (!remaining_ && !OpenBlock())
+            return false;
+        --remaining_;
+        ++count_;
+        if (!block_.CreateSeriesEntry(block_.GetBackend().InlineName()).SerializeInline(value))
+            good_ = false;
+        if (!good_)
+            end_ = true;
+        return good_;
+    }
+
+    /// Reads up to count elements into the batch, which is resized to the number read. Returns that number, which is less than count only at the end of the series or if reading has failed.
+    template<class Resizable>
+    unsigned Pull(Resizable& batch, unsigned count)
+    {
+        batch.Resize(count);
+        unsigned read = 0;
+        while (read < count && Pull(batch[read]))
+            ++read;
+        batch.Resize(read);
+        return read;
+    }
+
+    /// Returns the number of elements read so far.
+    unsigned long long GetCount() const { return count_; }
+    /// Returns true once the end of the series has been reached, or reading has failed.
+    bool IsEnd() const { return end_; }
+    /// Returns false if reading has failed. Reaching the end of the series is not a failure.
+    bool IsGood() const { return good_; }
+
+private:
+    /// Opens the next non-empty block. Returns false at the end of the series.
+    bool OpenBlock()
+    {
+        if (end_)
+            return false;
+        // Close the previous block first, so tagged binary skips what's left of it.
+        block_ = Archive(true, nullptr);
+        block_ = ar_.CreateSeriesEntry(name_);
+        unsigned size = 0;
+        // A missing block ends the series too, as with text backends that don't need the empty block.
+        if (!block_.SerializeSeriesSize(block_.GetBackend().InlineName(), size) || !size)
+        {
+            end_ = true;
+            return false;
+        }
+        remaining_ = size;
+        return true;
+    }
+
+    /// The archive read from.
+    Archive& ar_;
+    /// Name of the series.
+    String name_;
+    /// The block being read.
+    Archive block_{true, nullptr};
+    /// Elements left in the block.
+    unsigned remaining_{};
+    /// Elements read so far.
+    unsigned long long count_{};
+    /// False once reading has failed.
+    bool good_;
+    /// True once the end of the series has been reached.
+    bool end_;
+};
+
+}
@@ -1,12 +1,34 @@
 
-#define private public
-#include <Urho3D/Graphics/Material.h>
+#include <Urho3D/Core/Variant.h>
 
 #include "ArchiveUrhoTypes.h"
 
 namespace Urho3D
 {
 
+/// Archives one component of a vector-like type. Input accepts [x,y], [{"x":..},{"y":..}] or {"x":..,"y":..}; the series entry is probed once for both names.
+/// Both are probed as numbers: the inline value of an element object is the object itself, which would otherwise match before the name inside it is tried.
+template<class T>
+static bool ArchiveComponent(Archive& ar, const String& name, T& val)
+{
+    using Backend = Archival::Detail::Backend;
+    auto entry = ar.CreateSeriesEntryInline();
+    const String& inlineName = entry.GetBackend().InlineName();
+    if (!entry.IsInput())
+    {
+        if (entry.Serialize(inlineName, val))
+            return true;
+    }
+    else
+    {
+        const Backend::EntryAlternative alternatives[] = {{&inlineName, Backend::NUMBER_FORM}, {&name, Backend::NUMBER_FORM}};
+        const unsigned match = entry.GetBackend().FindEntry(alternatives, 2);
+        if (match == Backend::UNKNOWN_ENTRY ? entry.Serialize(inlineName, val) || entry.Serialize(name, val) : match < 2 && entry.Serialize(*alternatives[match].name, val))
+            return true;
+    }
+    return ar.Serialize(name, val);
+}
+
 ArchiveResult<Archive, IntVector2> ArchiveValue(Archive &archive, const String &name, IntVector2 &self)
 {
     if (Archival::ArchiveValue<Archive, IntVector2>(archive, name, self))
@@ -14,10 +36,8 @@ ArchiveResult<Archive, IntVector2> ArchiveValue(Archive &archive, const String &
 
     bool good = true;
     auto ar = archive.CreateGroup(name);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.x_).Else("x",self.x_))
-        ar.Serialize("x", self.x_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.y_).Else("y",self.y_))
-        ar.Serialize("y", self.y_);
+    ArchiveComponent(ar, "x", self.x_);
+    ArchiveComponent(ar, "y", self.y_);
     return {archive, good, self};
 }
 
@@ -32,12 +52,9 @@ ArchiveResult<Archive, Urho3D::IntVector3> ArchiveValue(Archive &archive, const
 //    ar.SerializeSeriesSize("value", sz);
 //    if (sz != 3)
 //        URHO3D_LOGERROR("Failures");
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.x_).Else("x",self.x_))
-        ar.Serialize("x", self.x_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.y_).Else("y",self.y_))
-        ar.Serialize("y", self.y_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.z_).Else("z",self.z_))
-        ar.Serialize("z", self.z_);
+    ArchiveComponent(ar, "x", self.x_);
+    ArchiveComponent(ar, "y", self.y_);
+    ArchiveComponent(ar, "z", self.z_);
     return {archive, good, self};
 }
 
@@ -48,10 +65,8 @@ ArchiveResult<Archive, Vector2> ArchiveValue(Archive &archive, const String &nam
 
     bool good = true;
     auto ar = archive.CreateGroup(name);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.x_).Else("x",self.x_))
-        ar.Serialize("x", self.x_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.y_).Else("y",self.y_))
-        ar.Serialize("y", self.y_);
+    ArchiveComponent(ar, "x", self.x_);
+    ArchiveComponent(ar, "y", self.y_);
     return {archive, good, self};
 }
 
@@ -66,12 +81,9 @@ ArchiveResult<Archive, Urho3D::Vector3> ArchiveValue(Archive &archive, const Str
 //    ar.SerializeSeriesSize("value", sz);
 //    if (sz != 3)
 //        URHO3D_LOGERROR("Failures");
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.x_).Else("x",self.x_))
-        ar.Serialize("x", self.x_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.y_).Else("y",self.y_))
-        ar.Serialize("y", self.y_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.z_).Else("z",self.z_))
-        ar.Serialize("z", self.z_);
+    ArchiveComponent(ar, "x", self.x_);
+    ArchiveComponent(ar, "y", self.y_);
+    ArchiveComponent(ar, "z", self.z_);
     return {archive, good, self};
 }
 
@@ -82,14 +94,10 @@ ArchiveResult<Archive, Vector4> ArchiveValue(Archive &archive, const String &nam
 
     bool good = true;
     auto ar = archive.CreateGroup(name);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.x_).Else("x",self.x_))
-        ar.Serialize("x", self.x_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.y_).Else("y",self.y_))
-        ar.Serialize("y", self.y_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.z_).Else("z",self.z_))
-        ar.Serialize("z", self.z_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.z_).Else("w",self.z_))
-        ar.Serialize("w", self.z_);
+    ArchiveComponent(ar, "x", self.x_);
+    ArchiveComponent(ar, "y", self.y_);
+    ArchiveComponent(ar, "z", self.z_);
+    ArchiveComponent(ar, "w", self.z_);
     return {archive, good, self};
 }
 
@@ -101,14 +109,10 @@ ArchiveResult<Archive, Quaternion> ArchiveValue(Archive& archive, const String&
 
     bool good = true;
     auto ar = archive.CreateGroup(name);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.z_).Else("w",self.z_))
-        ar.Serialize("w", self.z_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.x_).Else("x",self.x_))
-        ar.Serialize("x", self.x_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.y_).Else("y",self.y_))
-        ar.Serialize("y", self.y_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.z_).Else("z",self.z_))
-        ar.Serialize("z", self.z_);
+    ArchiveComponent(ar, "w", self.z_);
+    ArchiveComponent(ar, "x", self.x_);
+    ArchiveComponent(ar, "y", self.y_);
+    ArchiveComponent(ar, "z", self.z_);
     return {archive, good, self};
 }
 
@@ -119,14 +123,10 @@ ArchiveResult<Archive, Color> ArchiveValue(Archive &archive, const String &name,
 
     bool good = true;
     auto ar = archive.CreateGroup(name);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.r_).Else("r",self.r_))
-        ar.Serialize("r", self.r_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.g_).Else("g",self.g_))
-        ar.Serialize("g", self.g_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.b_).Else("b",self.b_))
-        ar.Serialize("b", self.b_);
-    if (!ar.CreateSeriesEntryInline().SerializeInline(self.a_).Else("a",self.a_))
-        ar.Serialize("a", self.a_);
+    ArchiveComponent(ar, "r", self.r_);
+    ArchiveComponent(ar, "g", self.g_);
+    ArchiveComponent(ar, "b", self.b_);
+    ArchiveComponent(ar, "a", self.a_);
     return {archive, good, self};
 }
 
@@ -153,9 +153,8 @@ ArchiveResult<Archive, Matrix3> ArchiveValue(Archive &archive, const String &nam
             auto i = r * ROWS + c;
             auto name = names[i];
             float& val = (&self.m00_)[i];
-            if (!row.CreateSeriesEntryInline().SerializeInline(val).Else(name,val))
-                if (!row.Serialize(name, val))
-                    ar.Serialize(name, val);
+            if (!ArchiveComponent(row, name, val))
+                ar.Serialize(name, val);
         }
 
     }
@@ -185,9 +184,8 @@ ArchiveResult<Archive, Matrix3x4> ArchiveValue(Archive &archive, const String &n
             auto i = r * ROWS + c;
             auto name = names[i];
             float& val = (&self.m00_)[i];
-            if (!row.CreateSeriesEntryInline().SerializeInline(val).Else(name,val))
-                if (!row.Serialize(name, val))
-                    ar.Serialize(name, val);
+            if (!ArchiveComponent(row, name, val))
+                ar.Serialize(name, val);
         }
 
     }
@@ -218,9 +216,8 @@ ArchiveResult<Archive, Matrix4> ArchiveValue(Archive &archive, const String &nam
             auto i = r * ROWS + c;
             auto name = names[i];
             float& val = (&self.m00_)[i];
-            if (!row.CreateSeriesEntryInline().SerializeInline(val).Else(name,val))
-                if (!row.Serialize(name, val))
-                    ar.Serialize(name, val);
+            if (!ArchiveComponent(row, name, val))
+                ar.Serialize(name, val);
         }
 
     }
@@ -228,103 +225,175 @@ ArchiveResult<Archive, Matrix4> ArchiveValue(Archive &archive, const String &nam
 }
 
 
-#if 0
+ArchiveResult<Archive, Rect> ArchiveValue(Archive &archive, const String &name, Rect &self)
+{
+    auto ar = archive.CreateGroup(name);
+    bool good = ar.Serialize("min", self.min_) && ar.Serialize("max", self.max_);
+    return {archive, good, self};
+}
 
-static_assert (sizeof(SharedPtr<Material>)==sizeof(Material*), "Shared Ptr Size differs");
+ArchiveResult<Archive, IntRect> ArchiveValue(Archive &archive, const String &name, IntRect &self)
+{
+    bool good = true;
+    auto ar = archive.CreateGroup(name);
+    good &= ArchiveComponent(ar, "left", self.left_);
+    good &= ArchiveComponent(ar, "top", self.top_);
+    good &= ArchiveComponent(ar, "right", self.right_);
+    good &= ArchiveComponent(ar, "bottom", self.bottom_);
+    return {archive, good, self};
+}
 
-static const char* textureUnitNames[10];
-TextureUnit ParseTextureUnitName(String name);
-ArchiveResult<Archive, Material> ArchiveValue(Archive &archive, const String &name, Material &self)
+ArchiveResult<Archive, ResourceRef> ArchiveValue(Archive &archive, const String &name, ResourceRef &self)
 {
     auto ar = archive.CreateGroup(name);
-    auto shader = ar.CreateGroup("shader");
-    shader.Serialize("vsdefines", self.vertexShaderDefines_);
-    shader.Serialize("psdefines", self.pixelShaderDefines_);
+    unsigned type = self.type_.Value();
+    bool good = ar.Serialize("type", type) && ar.Serialize("name", self.name_);
+    self.type_ = StringHash(type);
+    return {archive, good, self};
+}
 
-    auto techniquesGroup = ar.GetBackend().GetBackendName() == "XML" ? "technique" : "techniques";
+ArchiveResult<Archive, ResourceRefList> ArchiveValue(Archive &archive, const String &name, ResourceRefList &self)
+{
+    auto ar = archive.CreateGroup(name);
+    unsigned type = self.type_.Value();
+    bool good = ar.Serialize("type", type) && ar.Serialize("names", self.names_);
+    self.type_ = StringHash(type);
+    return {archive, good, self};
+}
 
-    ar.SerializeSeriesSize(techniquesGroup, self.techniques_);
-    for (unsigned i = 0; i < self.techniques_.Size(); ++i)
+/// Archives the type of a Variant: a byte for binary backends, the type name for text backends.
+static bool ArchiveVariantType(Archive& ar, VariantType& type)
+{
+    if (ar.GetBackend().PrefersBinaryData())
     {
-        auto techGroup = ar.CreateSeriesEntry(techniquesGroup);
-        auto techEntry = self.techniques_[i];
-
-        techGroup.Serialize("name", GetSet([&](){return techEntry.technique_->GetName();},
-        [&](const String& name){
-            auto technique = self.GetSubsystem<ResourceCache>()->GetResource(name);
-            techEntry.technique_ = techEntry.original_ = technique;
-        }));
-        if (techEntry.technique_)
-        {
-            techGroup.Serialize("quality", techEntry.qualityLevel_);
-            techGroup.Serialize("loddistance", techEntry.lodDistance_);
-        }
-        else
-        {
-            // We have already logged the error through the resource cache about not finding the technique.
-            self.techniques_.Erase(i);
-            --i;
-        }
+        unsigned char tag = static_cast<unsigned char>(type);
+        if (!ar.Serialize("type", tag) || tag >= MAX_VAR_TYPES)
+            return false;
+        type = static_cast<VariantType>(tag);
+        return true;
     }
+
+    String typeName = ar.IsInput() ? String::EMPTY : Variant::GetTypeName(type);
+    if (!ar.Serialize("type", typeName))
+        return false;
+    // Unknown names come back as VAR_NONE, which would load as an empty variant.
+    type = Variant::GetTypeFromName(typeName);
+    if (Variant::GetTypeName(type) != typeName)
+    {
+        URHO3D_LOGERROR("Unknown Variant type " + typeName + ".");
+        return false;
+    }
+    return true;
+}
+
+/// Archives the value of a Variant holding a T. Output archives the stored value without copying it; input archives into a temporary that is then assigned.
+template<class T>
+static bool ArchiveVariantValue(Archive& ar, Variant& variant, const T& stored)
+{
+    if (!ar.IsInput())
+        return ar.Serialize("value", const_cast<T&>(stored));
+
+    T value{};
+    if (!ar.Serialize("value", value))
+        return false;
+    variant = value;
+    return true;
+}
+
+/// Archives the value of a Variant holding a container in place, so that buffers, vectors and maps are never copied.
+template<class T>
+static bool ArchiveVariantContainer(Archive& ar, Variant& variant, T* (Variant::*getContainer)())
+{
     if (ar.IsInput())
+        variant = T();
+    T* container = (variant.*getContainer)();
+    return container && ar.Serialize("value", *container);
+}
+
+/// Archives the type and value of a Variant into the archive's current group, dispatching on the type straight to the backend primitive or extended type.
+static bool ArchiveVariantFields(Archive& ar, Variant& variant)
+{
+    VariantType type = variant.GetType();
+    if (!ArchiveVariantType(ar, type))
+        return false;
+
+    switch (type)
     {
-        self.SortTechniques();
-        self.ApplyShaderDefines();
+    case VAR_NONE:
+        if (ar.IsInput())
+            variant.Clear();
+        return true;
+    case VAR_INT: return ArchiveVariantValue(ar, variant, variant.GetInt());
+    case VAR_BOOL: return ArchiveVariantValue(ar, variant, variant.GetBool());
+    case VAR_FLOAT: return ArchiveVariantValue(ar, variant, variant.GetFloat());
+    case VAR_DOUBLE: return ArchiveVariantValue(ar, variant, variant.GetDouble());
+    case VAR_INT64: return ArchiveVariantValue(ar, variant, variant.GetInt64());
+    case VAR_STRING: return ArchiveVariantValue(ar, variant, variant.GetString());
+    case VAR_VECTOR2: return ArchiveVariantValue(ar, variant, variant.GetVector2());
+    case VAR_VECTOR3: return ArchiveVariantValue(ar, variant, variant.GetVector3());
+    case VAR_VECTOR4: return ArchiveVariantValue(ar, variant, variant.GetVector4());
+    case VAR_QUATERNION: return ArchiveVariantValue(ar, variant, variant.GetQuaternion());
+    case VAR_COLOR: return ArchiveVariantValue(ar, variant, variant.GetColor());
+    case VAR_INTVECTOR2: return ArchiveVariantValue(ar, variant, variant.GetIntVector2());
+    case VAR_INTVECTOR3: return ArchiveVariantValue(ar, variant, variant.GetIntVector3());
+    case VAR_MATRIX3: return ArchiveVariantValue(ar, variant, variant.GetMatrix3());
+    case VAR_MATRIX3X4: return ArchiveVariantValue(ar, variant, variant.GetMatrix3x4());
+    case VAR_MATRIX4: return ArchiveVariantValue(ar, variant, variant.GetMatrix4());
+    case VAR_RECT: return ArchiveVariantValue(ar, variant, variant.GetRect());
+    case VAR_INTRECT: return ArchiveVariantValue(ar, variant, variant.GetIntRect());
+    case VAR_RESOURCEREF: return ArchiveVariantValue(ar, variant, variant.GetResourceRef());
+    case VAR_RESOURCEREFLIST: return ArchiveVariantValue(ar, variant, variant.GetResourceRefList());
+    case VAR_BUFFER: return ArchiveVariantContainer(ar, variant, &Variant::GetBufferPtr);
+    case VAR_VARIANTVECTOR: return ArchiveVariantContainer(ar, variant, &Variant::GetVariantVectorPtr);
+    case VAR_STRINGVECTOR: return ArchiveVariantContainer(ar, variant, &Variant::GetStringVectorPtr);
+    case VAR_VARIANTMAP: return ArchiveVariantContainer(ar, variant, &Variant::GetVariantMapPtr);
+    default:
+        URHO3D_LOGERROR("Variant type " + Variant::GetTypeName(type) + " cannot be archived.");
+        return false;
     }
-    auto texturesGroup = ar.GetBackend().GetBackendName() == "XML" ? "texture" : "textures";
+}
 
+ArchiveResult<Archive, Variant> ArchiveValue(Archive &archive, const String &name, Variant &self)
+{
+    auto ar = archive.CreateGroup(name);
+    bool good = ArchiveVariantFields(ar, self);
+    return {archive, good, self};
+}
 
-    if (ar.GetBackend().GetBackendName() == "XML")
+ArchiveResult<Archive, VariantMap> ArchiveValue(Archive &archive, const String &name, VariantMap &self)
+{
+    unsigned size = self.Size();
+    if (!archive.SerializeSeriesSize(name, size))
+        return {archive, false, self};
+    if (archive.IsInput())
+        self.Clear();
+
+    // Binary backends store the key as its hash, text backends as its hex string.
+    bool good = true;
+    bool prefersBinary = archive.GetBackend().PrefersBinaryData();
+    auto it = self.Begin();
+    for (unsigned i = 0; i < size; ++i)
     {
-        unsigned size = self.textures_.Size();
-        ar.SerializeSeriesSize(techniquesGroup, size);
-        auto iterator = self.textures_.Begin();
-        for (unsigned i = 0; i < size; ++i)
+        auto entry = archive.CreateSeriesEntry(name);
+        if (archive.IsInput())
         {
-            auto texGroup = ar.CreateSeriesEntry(texturesGroup);
-            TextureUnit unit = ar.IsInput() ? iterator->first_ : TU_DIFFUSE;
-            Texture* tex = ar.IsInput() ? iterator->second_ : nullptr;
-            String unitName = textureUnitNames[(int)unit];
-            // Cannot serialize as a normal enum because of the shorthand names
-            VariantVector options;
-            textureUnitNames;
-            //TODO: add texture names to the options. Do it statically.
-            ar.Hint(Detail::Hint::SUGGESTED_OPTIONS, options);
-            ar.Serialize("unit", unitName);
-            ar.ClearHints();
-            if (ar.IsInput())
-            {
-                unit = ParseTextureUnitName(unitName);
-            }
-            if (unit < MAX_TEXTURE_UNITS)
-            {
-                ar.Serialize("name", GetSet([&](){return tex->GetName();},[&](const String& name){
-                    auto cache = self.GetSubsystem<ResourceCache>();
-
-                    // Detect cube maps and arrays by file extension: they are defined by an XML file
-                    if (GetExtension(name) == ".xml")
-                    {
-#ifdef DESKTOP_GRAPHICS
-                        StringHash type = ParseTextureTypeXml(cache, name);
-                        if (!type && unit == TU_VOLUMEMAP)
-                            type = Texture3D::GetTypeStatic();
-
-                        if (type == Texture3D::GetTypeStatic())
-                            SetTexture(unit, cache->GetResource<Texture3D>(name));
-                        else if (type == Texture2DArray::GetTypeStatic())
-                            SetTexture(unit, cache->GetResource<Texture2DArray>(name));
-                        else
-#endif
-                            SetTexture(unit, cache->GetResource<TextureCube>(name));
-                    }
-                    else
-                        SetTexture(unit, cache->GetResource<Texture2D>(name));
-                }));
-            }
+            unsigned key = 0;
+            String keyText;
+            if (prefersBinary ? !entry.Serialize("key", key) : !entry.Serialize("key", keyText))
+                return {archive, false, self};
+            if (!prefersBinary)
+                key = ToUInt(keyText, 16);
+            good &= ArchiveVariantFields(entry, self[StringHash(key)]);
+        }
+        else
+        {
+            unsigned key = it->first_.Value();
+            String keyText = it->first_.ToString();
+            good &= static_cast<bool>(prefersBinary ? entry.Serialize("key", key) : entry.Serialize("key", keyText));
+            good &= ArchiveVariantFields(entry, it->second_);
+            ++it;
         }
     }
-
-
+    return {archive, good, self};
 }
-#endif
 }
@@ -20,6 +20,19 @@ ArchiveResult<Archive, Color> ArchiveValue(Archive& archive, const String& name,
 ArchiveResult<Archive, Matrix3> ArchiveValue(Archive& archive, const String& name, Matrix3& self);
 ArchiveResult<Archive, Matrix3x4> ArchiveValue(Archive& archive, const String& name, Matrix3x4& self);
 ArchiveResult<Archive, Matrix4> ArchiveValue(Archive& archive, const String& name, Matrix4& self);
+ArchiveResult<Archive, Rect> ArchiveValue(Archive& archive, const String& name, Rect& self);
+ArchiveResult<Archive, IntRect> ArchiveValue(Archive& archive, const String& name, IntRect& self);
 
+/// Archives the type hash and name. Resolving the resource is up to the caller.
+ArchiveResult<Archive, ResourceRef> ArchiveValue(Archive& archive, const String& name, ResourceRef& self);
+ArchiveResult<Archive, ResourceRefList> ArchiveValue(Archive& archive, const String& name, ResourceRefList& self);
+
+/// Archives a Variant as a group of its type (a byte for binary backends, the type name for text backends) and its value, dispatched on the type straight to the backend primitive or extended type.
+/// Pointer and custom types are not supported. A VariantVector is archived as a series of these through the Vector overload.
+ArchiveResult<Archive, Variant> ArchiveValue(Archive& archive, const String& name, Variant& self);
+/// Archives a VariantMap (e.g. Node::GetVars()) as a series of entries holding the key hash and the variant's type and value. Input replaces the existing entries, like a Variant holding a VariantMap.
+ArchiveResult<Archive, VariantMap> ArchiveValue(Archive& archive, const String& name, VariantMap& self);
+
+/// Archives a Material through its MaterialDescription (see MaterialArchive.h). Input loads its techniques and textures in the background and applies them once they are all queued.
 ArchiveResult<Archive, Material> ArchiveValue(Archive& archive, const String& name, Material& self);
 }
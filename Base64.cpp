@@ -0,0 +1,205 @@
+#include "Base64.h"
+
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+inline namespace Archival {
+namespace Detail {
+
+namespace {
+
+const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/// Marks an invalid character in the decoding tables. Survives being OR-ed with any valid sextets.
+const unsigned INVALID{0xFF000000};
+
+/// Pairs of characters for every 12 bit value, so the scalar encoder does one lookup per two characters.
+struct EncodeTable
+{
+    char pairs[4096][2];
+
+    EncodeTable()
+    {
+        for (unsigned i = 0; i < 4096; ++i)
+        {
+            pairs[i][0] = ALPHABET[i >> 6];
+            pairs[i][1] = ALPHABET[i & 63];
+        }
+    }
+};
+
+/// The sextet of every character pre-shifted into place for each of the four positions of a quad, so the scalar decoder combines a quad with three ORs and checks it with a single test.
+struct DecodeTable
+{
+    unsigned shifted[4][256];
+
+    DecodeTable()
+    {
+        for (unsigned p = 0; p < 4; ++p)
+            for (unsigned c = 0; c < 256; ++c)
+                shifted[p][c] = INVALID;
+        for (unsigned i = 0; i < 64; ++i)
+            for (unsigned p = 0; p < 4; ++p)
+                shifted[p][static_cast<unsigned char>(ALPHABET[i])] = i << (18 - 6 * p);
+    }
+};
+
+const EncodeTable& GetEncodeTable() { static const EncodeTable table; return table; }
+const DecodeTable& GetDecodeTable() { static const DecodeTable table; return table; }
+
+#if defined(__SSSE3__)
+/// Encodes 12 bytes (reading 16) into 16 characters. Splits each 3 bytes into four sextets with multiplies, then maps sextets to characters by range with one shuffle.
+inline __m128i EncodeBlock(__m128i in)
+{
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    const __m128i sextets = _mm_or_si128(t1, t3);
+
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12: the index of the offset to add.
+    __m128i range = _mm_subs_epu8(sextets, _mm_set1_epi8(51));
+    const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), sextets);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(sextets, _mm_shuffle_epi8(offsets, range));
+}
+
+/// Decodes 16 characters into 12 bytes (in the low lanes). Classifies characters by their nibbles to validate and translate them, then packs the sextets with multiply-adds.
+inline bool DecodeBlock(__m128i in, __m128i& out)
+{
+    const __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    const __m128i lowNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+    const __m128i lowClass = _mm_shuffle_epi8(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A), lowNibbles);
+    const __m128i highClass = _mm_shuffle_epi8(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10), highNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lowClass, highClass), _mm_setzero_si128())) != 0xFFFF)
+        return false;
+
+    const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f));
+    const __m128i roll = _mm_shuffle_epi8(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0), _mm_add_epi8(slash, highNibbles));
+    const __m128i sextets = _mm_add_epi8(in, roll);
+
+    const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+    const __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    out = _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    return true;
+}
+#endif
+
+}
+
+void Base64::Encode(const unsigned char *source, unsigned size, char *dest)
+{
+    const unsigned char* end = source + size;
+
+#if defined(__SSSE3__)
+    while (end - source >= 16)
+    {
+        const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), EncodeBlock(in));
+        source += 12;
+        dest += 16;
+    }
+#endif
+
+    const EncodeTable& table = GetEncodeTable();
+    while (end - source >= 3)
+    {
+        const unsigned triple = (unsigned)source[0] << 16 | (unsigned)source[1] << 8 | source[2];
+        std::memcpy(dest, table.pairs[triple >> 12], 2);
+        std::memcpy(dest + 2, table.pairs[triple & 0xfff], 2);
+        source += 3;
+        dest += 4;
+    }
+
+    if (source == end)
+        return;
+    const unsigned triple = (unsigned)source[0] << 16 | (end - source == 2 ? (unsigned)source[1] << 8 : 0);
+    dest[0] = ALPHABET[triple >> 18];
+    dest[1] = ALPHABET[(triple >> 12) & 63];
+    dest[2] = end - source == 2 ? ALPHABET[(triple >> 6) & 63] : '=';
+    dest[3] = '=';
+}
+
+bool Base64::Decode(const char *source, unsigned length, unsigned char *dest, unsigned &size)
+{
+    if (length & 3)
+        return false;
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(source);
+    const unsigned char* end = in + length;
+    unsigned char* out = dest;
+
+    // The last quad may hold padding.
+    unsigned padding = 0;
+    if (length && in[length - 1] == '=')
+        padding = in[length - 2] == '=' ? 2 : 1;
+
+#if defined(__SSSE3__)
+    // Every block stores 16 bytes for 12, so stop while the quads left still decode to the 4 spare bytes.
+    while (end - in >= 24)
+    {
+        __m128i block;
+        if (!DecodeBlock(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), block))
+            return false;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), block);
+        in += 16;
+        out += 12;
+    }
+#endif
+
+    const DecodeTable& table = GetDecodeTable();
+    const unsigned char* full = end - (padding ? 4 : 0);
+    while (in < full)
+    {
+        const unsigned triple = table.shifted[0][in[0]] | table.shifted[1][in[1]] | table.shifted[2][in[2]] | table.shifted[3][in[3]];
+        if (triple & INVALID)
+            return false;
+        out[0] = static_cast<unsigned char>(triple >> 16);
+        out[1] = static_cast<unsigned char>(triple >> 8);
+        out[2] = static_cast<unsigned char>(triple);
+        in += 4;
+        out += 3;
+    }
+
+    if (padding)
+    {
+        const unsigned triple = table.shifted[0][in[0]] | table.shifted[1][in[1]] | (padding == 1 ? table.shifted[2][in[2]] : 0);
+        if (triple & INVALID)
+            return false;
+        *out++ = static_cast<unsigned char>(triple >> 16);
+        if (padding == 1)
+            *out++ = static_cast<unsigned char>(triple >> 8);
+    }
+
+    size = static_cast<unsigned>(out - dest);
+    return true;
+}
+
+Urho3D::String Base64::Encode(const Urho3D::PODVector<unsigned char> &buffer)
+{
+    Urho3D::String text;
+    if (buffer.Empty())
+        return text;
+    text.Resize(EncodedLength(buffer.Size()));
+    Encode(buffer.Buffer(), buffer.Size(), &text[0]);
+    return text;
+}
+
+bool Base64::Decode(const Urho3D::String &text, Urho3D::PODVector<unsigned char> &buffer)
+{
+    // Padding makes the decoded size up to two bytes smaller than the upper bound, so trim afterwards.
+    unsigned size = 0;
+    buffer.Resize(MaxDecodedSize(text.Length()));
+    if (!Decode(text.CString(), text.Length(), buffer.Buffer(), size))
+        return false;
+    buffer.Resize(size);
+    return true;
+}
+
+}
+}
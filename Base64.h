@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+
+inline namespace Archival {
+namespace Detail {
+
+/// Base64 (RFC 4648, padded, no line breaks) used by text backends to store opaque byte buffers.
+/// Works on raw memory so that callers can encode straight into and decode straight out of their own storage. Uses SSSE3 for 12 bytes at a time where the compiler targets it.
+struct Base64
+{
+    /// Returns the number of characters encoding size bytes produces.
+    static unsigned EncodedLength(unsigned size) { return (size + 2) / 3 * 4; }
+    /// Returns the most bytes the text can decode to. Decode returns the exact size.
+    static unsigned MaxDecodedSize(unsigned length) { return length / 4 * 3; }
+
+    /// Encodes size bytes of source into EncodedLength(size) characters of dest. Writes no terminator.
+    static void Encode(const unsigned char* source, unsigned size, char* dest);
+    /// Decodes length characters of source into dest, which must hold MaxDecodedSize(length) bytes. Returns false on malformed input, otherwise sets size to the number of bytes decoded.
+    static bool Decode(const char* source, unsigned length, unsigned char* dest, unsigned& size);
+
+    /// Encodes the buffer into a string.
+    static Urho3D::String Encode(const Urho3D::PODVector<unsigned char>& buffer);
+    /// Decodes the text into the buffer. Returns false on malformed input.
+    static bool Decode(const Urho3D::String& text, Urho3D::PODVector<unsigned char>& buffer);
+};
+
+}
+}
@@ -0,0 +1,833 @@
+#include "Base64.h"
+#include "BinaryBackend.h"
+
+inline namespace Archival {
+namespace Detail {
+
+BinaryBackend::BinaryBackend(Serializer &dest, const SizeTally *tally): state_(new State())
+{
+    state_->dest_ = &dest;
+    state_->tally_ = tally;
+    state_->lengthPrefixedGroups_ = tally != nullptr;
+}
+
+BinaryBackend::BinaryBackend(Deserializer &source, bool lengthPrefixedGroups): state_(new State()), groupStart_(source.GetPosition())
+{
+    state_->source_ = &source;
+    state_->lengthPrefixedGroups_ = lengthPrefixedGroups;
+}
+
+Archive BinaryBackend::MakeArchive(Serializer &dest, const SizeTally *tally, bool internStrings)
+{
+    if (tally && internStrings)
+    {
+        URHO3D_LOGERROR("BinaryBackend can't intern strings with a tally, which is measured without interning.");
+        return Archive(false, new NoOpBackend());
+    }
+    auto backend = new BinaryBackend(dest, tally);
+    backend->state_->internStrings_ = internStrings;
+    return Archive(false, backend);
+}
+
+BinaryBackend::~BinaryBackend()
+{
+    // A series whose entries weren't all written still goes out, so that what follows stays in order.
+    if (series_ && series_->buffer_)
+        FlushSeries();
+    if (groupBuffer_)
+        FlushBits();
+    if (seriesOwner_)
+        seriesOwner_->EndSeriesEntry();
+    if (seriesEnd_)
+        state_->source_->Seek(seriesEnd_);
+    // Entries of a series read as a group that weren't read are skipped, so that what follows the series is read next.
+    unsigned char tag;
+    for (; seriesGroupLeft_; --seriesGroupLeft_)
+    {
+        if (!MatchHeader(seriesGroup_, tag, TAG_ENTRY, TAG_ENTRY) || !SkipToEnd())
+            break;
+    }
+    if (!closesGroup_)
+        return;
+    if (state_->dest_)
+        state_->dest_->WriteUByte(TAG_END);
+    else
+        SkipToEnd();
+}
+
+Archive BinaryBackend::MakeArchive(Deserializer &source, bool lengthPrefixedGroups, bool internStrings)
+{
+    if (lengthPrefixedGroups && internStrings)
+    {
+        URHO3D_LOGERROR("BinaryBackend can't read interned strings with length prefixed groups, which are written without interning.");
+        return Archive(true, new NoOpBackend());
+    }
+    auto backend = new BinaryBackend(source, lengthPrefixedGroups);
+    backend->state_->internStrings_ = internStrings;
+    return Archive(true, backend);
+}
+
+Archive BinaryBackend::MakeTaggedArchive(Serializer &dest, bool internStrings)
+{
+    auto backend = new BinaryBackend(dest);
+    backend->state_->tagged_ = true;
+    backend->state_->internStrings_ = internStrings;
+    return Archive(false, backend);
+}
+
+Archive BinaryBackend::MakeTaggedArchive(Deserializer &source, bool internStrings)
+{
+    auto backend = new BinaryBackend(source);
+    backend->state_->tagged_ = true;
+    backend->state_->internStrings_ = internStrings;
+    return Archive(true, backend);
+}
+
+Archive BinaryBackend::MakeIndexedArchive(Serializer &dest)
+{
+    auto backend = new BinaryBackend(dest);
+    backend->state_->indexed_ = true;
+    return Archive(false, backend);
+}
+
+Archive BinaryBackend::MakeIndexedArchive(Deserializer &source)
+{
+    auto backend = new BinaryBackend(source);
+    backend->state_->indexed_ = true;
+    return Archive(true, backend);
+}
+
+Backend *BinaryBackend::CreateGroup(const String &name, bool isInput)
+{
+    if (state_->tagged_)
+    {
+        unsigned char tag;
+        if (isInput ? !MatchHeader(name, tag, TAG_GROUP, TAG_SERIES) : !WriteHeader(TAG_GROUP, name))
+            return nullptr;
+        if (tag != TAG_SERIES)
+            return new BinaryBackend(state_, true, isInput ? state_->source_->GetPosition() : 0);
+
+        // A series read as a group holds its entries inline, as JSONBackend reads an array, so that values JSON stores as arrays (Vector3, Color, ...) load from what was cooked from it.
+        auto group = new BinaryBackend(state_, false, state_->source_->GetPosition());
+        group->seriesGroup_ = KeyName(name);
+        group->seriesGroupLeft_ = state_->source_->ReadVLE();
+        return group;
+    }
+
+    if (state_->lengthPrefixedGroups_)
+    {
+        if (isInput)
+        {
+            if (!state_->source_ || state_->source_->IsEof())
+                return nullptr;
+            state_->source_->ReadVLE();
+        }
+        else
+        {
+            const SizeTally* tally = state_->tally_;
+            if (!tally || state_->nextGroup_ >= tally->groupSizes.Size())
+            {
+                URHO3D_LOGERROR("BinaryBackend traversal does not match the counting pass. Group=" + KeyName(name));
+                return nullptr;
+            }
+            state_->dest_->WriteVLE(tally->groupSizes[state_->nextGroup_++]);
+        }
+    }
+
+    auto group = new BinaryBackend(state_);
+    if (!group->BeginBits(isInput))
+    {
+        delete group;
+        return nullptr;
+    }
+    return group;
+}
+
+Backend *BinaryBackend::CreateSeriesEntry(const String &name, bool isInput)
+{
+    if (state_->tagged_)
+    {
+        unsigned char tag;
+        if (!seriesGroup_.Empty())
+        {
+            if (!isInput || !IsInline(name) || !seriesGroupLeft_ || !MatchHeader(seriesGroup_, tag, TAG_ENTRY, TAG_ENTRY))
+                return nullptr;
+            --seriesGroupLeft_;
+            return new BinaryBackend(state_, true, state_->source_->GetPosition());
+        }
+        if (isInput)
+        {
+            // Readers that don't ask for the size still find the entries after it. Only the first entry looks, as later ones would miss and scan the whole group.
+            if (!seriesSized_.Contains(name))
+            {
+                seriesSized_.Insert(name);
+                if (MatchHeader(name, tag, TAG_SERIES, TAG_SERIES))
+                    state_->source_->ReadVLE();
+            }
+            if (!MatchHeader(name, tag, TAG_ENTRY, TAG_ENTRY))
+                return nullptr;
+        }
+        else if (!WriteHeader(TAG_ENTRY, name))
+            return nullptr;
+        return new BinaryBackend(state_, true, isInput ? state_->source_->GetPosition() : 0);
+    }
+
+    // Input is left after an indexed series once its size is read, so its entries are opened through the offset table.
+    if (isInput && series_ && series_->name_ == name)
+        return CreateSeriesEntryAt(name, series_->next_++, true);
+    if (isInput && (!state_->source_ || state_->source_->IsEof()))
+        return nullptr;
+    auto entry = new BinaryBackend(state_);
+    if (!isInput && series_ && series_->buffer_)
+    {
+        series_->offsets_.Push(series_->buffer_->GetSize());
+        entry->seriesOwner_ = this;
+    }
+    return entry;
+}
+
+Backend *BinaryBackend::CreateSeriesEntryAt(const String &name, unsigned index, bool isInput)
+{
+    if (!state_->indexed_ || !series_ || series_->name_ != name)
+        return nullptr;
+    // Output is positional, so entries can only be written in order.
+    if (!isInput)
+        return series_->buffer_ && index == series_->offsets_.Size() ? CreateSeriesEntry(name, false) : nullptr;
+
+    if (index >= series_->size_ || !state_->source_->Seek(series_->start_ + series_->offsets_[index]))
+        return nullptr;
+    auto entry = new BinaryBackend(state_);
+    entry->seriesEnd_ = series_->end_;
+    return entry;
+}
+
+bool BinaryBackend::GetSeriesSize(const String &name, unsigned &size)
+{
+    return ReadSeriesSize(name, size, state_->indexed_);
+}
+
+bool BinaryBackend::SetSeriesSize(const String &name, const unsigned &size)
+{
+    return WriteSeriesSize(name, size, state_->indexed_);
+}
+
+bool BinaryBackend::ReadSeriesSize(const String &name, unsigned &size, bool indexed)
+{
+    unsigned char tag;
+    Deserializer* source = state_->source_;
+    if (!seriesGroup_.Empty())
+    {
+        size = seriesGroupLeft_;
+        return IsInline(name);
+    }
+    if (state_->tagged_)
+        seriesSized_.Insert(name);
+    if (!source || (state_->tagged_ ? !MatchHeader(name, tag, TAG_SERIES, TAG_SERIES) : source->IsEof()))
+        return false;
+    size = source->ReadVLE();
+    if (!indexed)
+        return true;
+
+    // An empty series is kept too, so that its entries fail rather than read what follows as another size.
+    series_.Reset();
+    UniquePtr<IndexedSeries> series(new IndexedSeries());
+    series->name_ = name;
+    series->size_ = size;
+    series->start_ = series->end_ = source->GetPosition();
+    if (size)
+    {
+        // Check the table fits before allocating it, so corrupt data can't ask for gigabytes.
+        if ((static_cast<unsigned long long>(size) + 1) * sizeof(unsigned) > source->GetSize() - source->GetPosition())
+            return false;
+        series->offsets_.Resize(size);
+        if (source->Read(&series->offsets_[0], size * sizeof(unsigned)) != size * sizeof(unsigned))
+            return false;
+        const unsigned length = source->ReadUInt();
+        series->start_ = source->GetPosition();
+        series->end_ = series->start_ + length;
+        // Whatever follows is read from after the series, whether or not any entry is opened.
+        if (series->end_ > source->GetSize() || !source->Seek(series->end_))
+            return false;
+    }
+    series_ = std::move(series);
+    return true;
+}
+
+bool BinaryBackend::WriteSeriesSize(const String &name, unsigned size, bool indexed)
+{
+    if (!state_->dest_ || (state_->tagged_ && !WriteHeader(TAG_SERIES, name)))
+        return false;
+    if (!state_->dest_->WriteVLE(size))
+        return false;
+    if (!indexed || !size)
+        return true;
+
+    // Buffer the entries until the last one closes, so that the offset table can precede them.
+    if (series_ && series_->buffer_)
+        FlushSeries();
+    series_.Reset(new IndexedSeries());
+    series_->name_ = name;
+    series_->size_ = size;
+    series_->buffer_.Reset(new VectorBuffer());
+    series_->parentDest_ = state_->dest_;
+    state_->dest_ = series_->buffer_.Get();
+    return true;
+}
+
+void BinaryBackend::EndSeriesEntry()
+{
+    if (series_ && series_->buffer_ && ++series_->closed_ == series_->size_)
+        FlushSeries();
+}
+
+void BinaryBackend::FlushSeries()
+{
+    VectorBuffer& buffer = *series_->buffer_;
+    Serializer* dest = series_->parentDest_;
+    state_->dest_ = dest;
+    // Entries that were never written point at the end of the series.
+    while (series_->offsets_.Size() < series_->size_)
+        series_->offsets_.Push(buffer.GetSize());
+    dest->Write(&series_->offsets_[0], series_->size_ * sizeof(unsigned));
+    dest->WriteUInt(buffer.GetSize());
+    if (buffer.GetSize())
+        dest->Write(buffer.GetData(), buffer.GetSize());
+    series_->buffer_.Reset();
+}
+
+bool BinaryBackend::GetEntryNames(StringVector &names)
+{
+    if (state_->tagged_)
+    {
+        // Scan the headers of the rest of the group, then move back so the entries can be read.
+        if (!state_->source_)
+            return false;
+        unsigned start = state_->source_->GetPosition();
+        unsigned char tag;
+        String name;
+        bool good = true;
+        HashSet<String> listed;
+        for (const String& listedName : names)
+            listed.Insert(listedName);
+        while (!state_->source_->IsEof())
+        {
+            if (!ReadHeader(tag, name))
+            {
+                good = false;
+                break;
+            }
+            if (tag == TAG_END)
+                break;
+            // Series entries share a name, so list it once. Looked up in a set, as a group can hold thousands of entries.
+            if (!listed.Contains(name))
+            {
+                listed.Insert(name);
+                names.Push(name);
+            }
+            if (!SkipPayload(tag))
+            {
+                good = false;
+                break;
+            }
+        }
+        state_->source_->Seek(start);
+        return good;
+    }
+
+    // Names are not series entries, so they never have an offset table.
+    unsigned count;
+    if (!ReadSeriesSize(InlineName(), count, false))
+        return false;
+
+    names.Reserve(names.Size() + count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        names.Push(String::EMPTY);
+        if (!Get(InlineName(), names.Back()))
+            return false;
+    }
+    return true;
+}
+
+bool BinaryBackend::SetEntryNames(const StringVector &names)
+{
+    // Every entry already stores its name.
+    if (state_->tagged_)
+        return state_->dest_;
+
+    if (!WriteSeriesSize(InlineName(), names.Size(), false))
+        return false;
+    for (const String& name : names)
+        if (!Set(InlineName(), name))
+            return false;
+    return true;
+}
+
+bool BinaryBackend::GetRecord(RecordField *fields, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        if (!VisitRecordField(fields[i], [this](const String& name, auto& val) { return BinaryBackend::Get(name, val); }))
+            return false;
+    return true;
+}
+
+bool BinaryBackend::SetRecord(const RecordField *fields, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+        if (!VisitRecordField(fields[i], [this](const String& name, auto& val) { return BinaryBackend::Set(name, val); }))
+            return false;
+    return true;
+}
+
+bool BinaryBackend::WritePresence(const String &name, bool present, bool isInput)
+{
+    if (state_->tagged_)
+        return Backend::WritePresence(name, present, isInput);
+
+    if (isInput)
+        return ReadBit(present) && present;
+    WriteBit(present);
+    return present;
+}
+
+bool BinaryBackend::WriteConditional(bool condition, bool isInput)
+{
+    // Missing entries fail cleanly in the tagged layout, so there's nothing to bake.
+    if (state_->tagged_)
+        return Backend::WriteConditional(condition, isInput);
+
+    if (isInput)
+        return ReadBit(condition) && condition;
+    WriteBit(condition);
+    return condition;
+}
+
+unsigned BinaryBackend::FindEntry(const EntryAlternative *alternatives, unsigned count)
+{
+    if (!state_->tagged_ || !state_->source_)
+        return count ? 0 : MISSING_ENTRY;
+
+    unsigned char tag;
+    unsigned offset;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const String& name = *alternatives[i].name;
+        switch (alternatives[i].form)
+        {
+        case ANY_FORM:
+            if (FindHeader(name, RECORD_BOOL, TAG_BLOB, tag, offset))
+                return i;
+            break;
+        case NUMBER_FORM:
+            if (FindHeader(name, RECORD_BOOL, RECORD_DOUBLE, tag, offset))
+                return i;
+            break;
+        case STRING_FORM:
+            if (FindHeader(name, RECORD_STRING, RECORD_STRING, tag, offset))
+                return i;
+            break;
+        case GROUP_FORM:
+            if (FindHeader(name, TAG_GROUP, TAG_GROUP, tag, offset))
+                return i;
+            break;
+        case SERIES_FORM:
+            if (FindHeader(name, TAG_SERIES, TAG_ENTRY, tag, offset))
+                return i;
+            break;
+        case BUFFER_FORM:
+            if (FindHeader(name, TAG_BLOB, TAG_BLOB, tag, offset) || FindHeader(name, RECORD_STRING, RECORD_STRING, tag, offset))
+                return i;
+            break;
+        }
+    }
+    return MISSING_ENTRY;
+}
+
+bool BinaryBackend::DescribeEntry(const String &name, EntryForm &form, RecordFieldType &type)
+{
+    unsigned char tag;
+    unsigned offset;
+    if (!state_->tagged_ || !FindHeader(name, RECORD_NONE, TAG_BLOB, tag, offset))
+        return false;
+
+    type = RECORD_NONE;
+    switch (tag)
+    {
+    case TAG_GROUP:
+        form = GROUP_FORM;
+        break;
+    case TAG_SERIES:
+    case TAG_ENTRY:
+        form = SERIES_FORM;
+        break;
+    case TAG_BLOB:
+        form = BUFFER_FORM;
+        break;
+    case RECORD_NONE:
+        form = ANY_FORM;
+        break;
+    case RECORD_STRING:
+        form = STRING_FORM;
+        type = RECORD_STRING;
+        break;
+    default:
+        form = NUMBER_FORM;
+        type = static_cast<RecordFieldType>(tag);
+        break;
+    }
+    return true;
+}
+
+bool BinaryBackend::Get(const String &name, const std::nullptr_t &)
+{
+    unsigned char tag;
+    if (state_->tagged_)
+        return MatchHeader(name, tag, RECORD_NONE, RECORD_NONE);
+    return state_->source_;
+}
+
+bool BinaryBackend::Set(const String &name, const std::nullptr_t &)
+{
+    if (state_->tagged_)
+        return WriteHeader(RECORD_NONE, name);
+    return state_->dest_;
+}
+
+bool BinaryBackend::Get(const String &name, String &val)
+{
+    unsigned char tag;
+    if (!state_->source_ || (state_->tagged_ ? !MatchHeader(name, tag, RECORD_STRING, RECORD_STRING) : state_->source_->IsEof()))
+        return false;
+
+    return ReadString(val);
+}
+
+bool BinaryBackend::Set(const String &name, const String &val)
+{
+    if (!state_->dest_ || (state_->tagged_ && !WriteHeader(RECORD_STRING, name)))
+        return false;
+    return WriteString(val);
+}
+
+bool BinaryBackend::Get(const String &name, PODVector<unsigned char> &val)
+{
+    Deserializer* source = state_->source_;
+    if (!source)
+        return false;
+
+    unsigned char tag;
+    if (state_->tagged_ && !MatchHeader(name, tag, TAG_BLOB, TAG_BLOB))
+    {
+        String text;
+        return Get(name, text) && Base64::Decode(text, val);
+    }
+
+    if (source->GetSize() - source->GetPosition() < sizeof(unsigned))
+        return false;
+    unsigned size = source->ReadUInt();
+    if (size > source->GetSize() - source->GetPosition())
+        return false;
+    val.Resize(size);
+    return !size || source->Read(&val[0], size) == size;
+}
+
+bool BinaryBackend::Set(const String &name, const PODVector<unsigned char> &val)
+{
+    if (!state_->dest_ || (state_->tagged_ && !WriteHeader(TAG_BLOB, name)))
+        return false;
+
+    unsigned size = val.Size();
+    state_->dest_->WriteUInt(size);
+    return !size || state_->dest_->Write(&val[0], size) == size;
+}
+
+bool BinaryBackend::BeginBits(bool isInput)
+{
+    packsBits_ = true;
+    if (isInput)
+    {
+        Deserializer* source = state_->source_;
+        if (!source || source->IsEof())
+            return false;
+        bitCount_ = source->ReadVLE();
+        bits_.Resize((bitCount_ + 7) >> 3);
+        return bits_.Empty() || source->Read(&bits_[0], bits_.Size()) == bits_.Size();
+    }
+
+    // The counting pass already has the group's bits, so write them now and its contents straight after. CreateGroup has just written the length prefix of the same group.
+    const SizeTally* tally = state_->tally_;
+    const unsigned index = state_->nextGroup_ - 1;
+    if (tally && index < tally->groupBitCounts.Size())
+    {
+        bitCount_ = tally->groupBitCounts[index];
+        tallyBits_ = tally->groupBits.Buffer() + tally->groupBitOffsets[index];
+        bitsWritten_ = true;
+        state_->dest_->WriteVLE(bitCount_);
+        return !bitCount_ || state_->dest_->Write(tallyBits_, (bitCount_ + 7) >> 3) == (bitCount_ + 7) >> 3;
+    }
+
+    // Otherwise buffer the contents until the group closes, so that its bits can precede them.
+    outerBitsGroup_ = state_->bitsGroup_;
+    state_->bitsGroup_ = this;
+    parentDest_ = state_->dest_;
+    groupBuffer_.Reset(new VectorBuffer());
+    state_->dest_ = groupBuffer_.Get();
+    return true;
+}
+
+void BinaryBackend::FlushBits()
+{
+    // Groups created after this one write into its buffer, so they are flushed first rather than left writing into it once freed.
+    if (state_->bitsGroup_ != this)
+    {
+        URHO3D_LOGERROR("BinaryBackend groups must be closed in the reverse order they were created.");
+        while (state_->bitsGroup_ != this)
+            state_->bitsGroup_->FlushBits();
+    }
+    state_->bitsGroup_ = outerBitsGroup_;
+    state_->dest_ = parentDest_;
+    parentDest_->WriteVLE(bitCount_);
+    if (!bits_.Empty())
+        parentDest_->Write(&bits_[0], bits_.Size());
+    if (groupBuffer_->GetSize())
+        parentDest_->Write(groupBuffer_->GetData(), groupBuffer_->GetSize());
+    groupBuffer_.Reset();
+}
+
+bool BinaryBackend::ReadBit(bool &bit)
+{
+    if (!packsBits_)
+        return GetPOD(bit);
+    if (nextBit_ >= bitCount_)
+        return false;
+    bit = (bits_[nextBit_ >> 3] >> (nextBit_ & 7)) & 1;
+    ++nextBit_;
+    return true;
+}
+
+bool BinaryBackend::WriteBit(bool bit)
+{
+    if (!packsBits_)
+        return SetPOD(bit);
+    if (bitsWritten_)
+    {
+        // The bits are already written, so only check the traversal still matches them.
+        if (nextBit_ >= bitCount_ || static_cast<bool>((tallyBits_[nextBit_ >> 3] >> (nextBit_ & 7)) & 1) != bit)
+        {
+            URHO3D_LOGERROR("BinaryBackend traversal does not match the counting pass. Bit=" + String(nextBit_));
+            return false;
+        }
+        ++nextBit_;
+        return true;
+    }
+    if ((bitCount_ & 7) == 0)
+        bits_.Push(0);
+    if (bit)
+        bits_.Back() |= 1 << (bitCount_ & 7);
+    ++bitCount_;
+    return true;
+}
+
+bool BinaryBackend::WriteString(const String &value)
+{
+    Serializer* dest = state_->dest_;
+    if (state_->internStrings_)
+    {
+        // The low bit of the code tells a definition from a reference, so the ID can be checked on its own wherever the definition is read from.
+        auto it = state_->stringIds_.Find(value);
+        if (it != state_->stringIds_.End())
+            return dest->WriteVLE(it->second_ << 1u);
+        const unsigned id = state_->stringIds_.Size();
+        state_->stringIds_[value] = id;
+        if (!dest->WriteVLE(id << 1u | 1u))
+            return false;
+    }
+
+    unsigned length = value.Length();
+    return dest->WriteVLE(length) && (!length || dest->Write(value.CString(), length) == length);
+}
+
+bool BinaryBackend::ReadString(String &value)
+{
+    Deserializer* source = state_->source_;
+    unsigned id = 0;
+    if (state_->internStrings_)
+    {
+        const unsigned code = source->ReadVLE();
+        id = code >> 1u;
+        if (!(code & 1u))
+        {
+            if (id >= state_->strings_.Size())
+                return false;
+            value = state_->strings_[id];
+            return true;
+        }
+    }
+
+    // Definitions are read in stream order, so a new one always takes the next ID. Anything further is corrupt, and must not grow the table.
+    if (state_->internStrings_ && id > state_->strings_.Size())
+        return false;
+    unsigned length = source->ReadVLE();
+    if (length > source->GetSize() - source->GetPosition())
+        return false;
+    value.Resize(length);
+    if (length && source->Read(const_cast<char*>(value.CString()), length) != length)
+        return false;
+    if (state_->internStrings_)
+    {
+        // Out of order reads of the tagged layout may read a definition more than once, which sets the same ID again.
+        if (id == state_->strings_.Size())
+            state_->strings_.Push(value);
+        else
+            state_->strings_[id] = value;
+    }
+    return true;
+}
+
+bool BinaryBackend::WriteHeader(unsigned char tag, const String &name)
+{
+    if (!state_->dest_)
+        return false;
+    return state_->dest_->WriteUByte(tag) && WriteString(KeyName(name));
+}
+
+bool BinaryBackend::ReadHeader(unsigned char &tag, String &name)
+{
+    Deserializer* source = state_->source_;
+    if (!source || source->IsEof())
+        return false;
+
+    tag = source->ReadUByte();
+    if (tag == TAG_END)
+    {
+        name.Clear();
+        return true;
+    }
+    return ReadString(name);
+}
+
+bool BinaryBackend::FindHeader(const String &name, unsigned char first, unsigned char last, unsigned char &tag, unsigned &offset)
+{
+    Deserializer* source = state_->source_;
+    if (!source)
+        return false;
+
+    const String& key = KeyName(name);
+    // A series read as a group only holds the entries of the series, not what follows them.
+    if (!seriesGroup_.Empty() && key != seriesGroup_)
+        return false;
+    unsigned start = source->GetPosition();
+    String stored;
+
+    // Usually it's the next entry. Otherwise it was stored out of order (e.g. a hand-edited source), so look through the rest of the group,
+    // then wrap around to its start, for an entry not yet read.
+    bool found = false;
+    bool wrapped = false;
+    for (;;)
+    {
+        offset = source->GetPosition();
+        if (wrapped && offset >= start)
+            break;
+        if (!ReadHeader(tag, stored) || tag == TAG_END)
+        {
+            if (wrapped || start == groupStart_)
+                break;
+            wrapped = true;
+            source->Seek(groupStart_);
+            continue;
+        }
+        if (tag >= first && tag <= last && stored == key && !consumed_.Contains(offset))
+        {
+            found = true;
+            break;
+        }
+        if (!SkipPayload(tag))
+            break;
+    }
+    source->Seek(start);
+    return found;
+}
+
+bool BinaryBackend::MatchHeader(const String &name, unsigned char &tag, unsigned char first, unsigned char last)
+{
+    Deserializer* source = state_->source_;
+    if (!source)
+        return false;
+
+    if (!seriesGroup_.Empty() && KeyName(name) != seriesGroup_)
+        return false;
+    unsigned start = source->GetPosition();
+    String stored;
+    if (!ReadHeader(tag, stored) || tag == TAG_END || tag < first || tag > last || stored != KeyName(name) || (jumped_ && consumed_.Contains(start)))
+    {
+        unsigned offset;
+        source->Seek(start);
+        if (!FindHeader(name, first, last, tag, offset))
+            return false;
+        source->Seek(offset);
+        ReadHeader(tag, stored);
+        jumped_ = true;
+        start = offset;
+    }
+    consumed_.Insert(start);
+    return true;
+}
+
+bool BinaryBackend::SkipPayload(unsigned char tag)
+{
+    Deserializer* source = state_->source_;
+    unsigned size = 0;
+    switch (tag)
+    {
+    case TAG_GROUP:
+    case TAG_ENTRY:
+        return SkipToEnd();
+    case TAG_SERIES:
+        source->ReadVLE();
+        return true;
+    case RECORD_NONE: break;
+    case RECORD_BOOL: size = sizeof(bool); break;
+    case RECORD_UCHAR: size = sizeof(unsigned char); break;
+    case RECORD_SCHAR: size = sizeof(signed char); break;
+    case RECORD_USHORT: size = sizeof(unsigned short); break;
+    case RECORD_SSHORT: size = sizeof(signed short); break;
+    case RECORD_UINT: size = sizeof(unsigned int); break;
+    case RECORD_SINT: size = sizeof(signed int); break;
+    case RECORD_ULONGLONG: size = sizeof(unsigned long long); break;
+    case RECORD_SLONGLONG: size = sizeof(signed long long); break;
+    case RECORD_FLOAT: size = sizeof(float); break;
+    case RECORD_DOUBLE: size = sizeof(double); break;
+    case RECORD_STRING:
+        if (state_->internStrings_)
+        {
+            // Read rather than skip, so that an interned definition is known when it's referred to later.
+            String skipped;
+            return ReadString(skipped);
+        }
+        size = source->ReadVLE();
+        break;
+    case TAG_BLOB: size = source->ReadUInt(); break;
+    default:
+        URHO3D_LOGERROR("BinaryBackend found an unknown tag in the tagged layout.");
+        return false;
+    }
+    unsigned target = source->GetPosition() + size;
+    return target <= source->GetSize() && source->Seek(target) == target;
+}
+
+bool BinaryBackend::SkipToEnd()
+{
+    unsigned char tag;
+    String name;
+    while (ReadHeader(tag, name))
+    {
+        if (tag == TAG_END)
+            return true;
+        if (!SkipPayload(tag))
+            return false;
+    }
+    return false;
+}
+
+}
+}
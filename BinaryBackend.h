@@ -0,0 +1,370 @@
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/RefCounted.h>
+#include <Urho3D/IO/Deserializer.h>
+#include <Urho3D/IO/Serializer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+#include <type_traits>
+
+#include "SizeCountingBackend.h"
+
+inline namespace Archival {
+namespace Detail {
+
+using namespace Urho3D;
+
+/// Archival Backend that serializes to/from a compact positional binary stream.
+/// Names are not stored, so values are read back in the order they were written. ArchiveValue overloads must take the same path on input as on output:
+/// use SerializeSeriesSize, SerializeEntryNames and WriteConditional for anything dynamic.
+/// Every group starts with a block of packed bits holding its presence flags, conditionals and bools, least significant bit first, so each takes a bit rather than a byte.
+/// Given the tally of a counting pass (see WriteSized), groups write the bits it recorded up front and their contents straight to the output. Otherwise they are buffered until they close so that the bits can precede their contents.
+/// The root and series entries have no bit block and spend a byte on each.
+/// The tagged layout (MakeTaggedArchive) instead precedes every entry with a type tag and its name, so the stream describes itself: missing entries fail without consuming anything,
+/// unread entries are skipped at the end of their group, and the Transcoder can walk it without the ArchiveValue code.
+/// Either of the first two can intern strings: the first occurrence of a string (value, or name in the tagged layout) defines an ID, and later occurrences only write the ID.
+/// The indexed layout (MakeIndexedArchive) is the positional one with an offset table after the size of every series, so that CreateSeriesEntryAt reads any entry directly. Series entries are buffered on output until the last one closes.
+class BinaryBackend: public Backend
+{
+    /// Stream state shared by the root backend and every group/series entry created from it.
+    struct State: public RefCounted
+    {
+        /// The output stream, or null for input.
+        Serializer* dest_{};
+        /// The input stream, or null for output.
+        Deserializer* source_{};
+        /// Tally from a counting pass used to write length-prefixed groups. Output only, may be null.
+        const SizeTally* tally_{};
+        /// Index of the next group to be created, into SizeTally::groupSizes.
+        unsigned nextGroup_{};
+        /// True if groups are prefixed with their byte length.
+        bool lengthPrefixedGroups_{};
+        /// The innermost positional group whose contents are buffered on output, which dest_ points into. Null if none.
+        BinaryBackend* bitsGroup_{};
+        /// True for the tagged layout.
+        bool tagged_{};
+        /// True for the indexed layout.
+        bool indexed_{};
+        /// True if strings are interned.
+        bool internStrings_{};
+        /// IDs of the interned strings written so far. Output only.
+        HashMap<String, unsigned> stringIds_;
+        /// Interned strings read so far, by ID. Input only.
+        Vector<String> strings_;
+    };
+
+    /// A series of the indexed layout being written or read by the backend its size was serialized with.
+    struct IndexedSeries
+    {
+        /// Name of the series, which entries must be created with.
+        String name_;
+        /// Number of entries.
+        unsigned size_{};
+        /// Offsets of the entries from the start of the first one. Filled in as they are created on output.
+        PODVector<unsigned> offsets_;
+        /// Number of entries closed so far on output. The series is written out when the last one closes.
+        unsigned closed_{};
+        /// Buffer holding the entries on output until the series is written out.
+        UniquePtr<VectorBuffer> buffer_;
+        /// The output the series is written to.
+        Serializer* parentDest_{};
+        /// Input offsets of the first entry and of the end of the series.
+        unsigned start_{};
+        unsigned end_{};
+        /// Index of the entry CreateSeriesEntry opens next on input.
+        unsigned next_{};
+    };
+
+    /// Internal constructor for groups and series entries. Set closesGroup for those that end with TAG_END in the tagged layout, which start reading at groupStart.
+    BinaryBackend(State* state, bool closesGroup = false, unsigned groupStart = 0): state_(state), closesGroup_(closesGroup), groupStart_(groupStart) {}
+
+public:
+
+    /// Tags preceding entries in the tagged layout, after the scalar RecordFieldType values (RECORD_NONE for null).
+    enum Tag : unsigned char
+    {
+        /// Ends a group or series entry. Has no name.
+        TAG_END = 0x80,
+        /// A group, followed by its entries and a TAG_END.
+        TAG_GROUP,
+        /// The size of a series, as a VLE.
+        TAG_SERIES,
+        /// A series entry, followed by its entries and a TAG_END.
+        TAG_ENTRY,
+        /// A byte buffer, as a UInt size followed by the bytes.
+        TAG_BLOB,
+    };
+
+    /// Construct to write to the provided stream, which must outlive the backend.
+    /// If a tally from a SizeCountingBackend pass (FORMAT_BINARY, lengthPrefixedGroups) over the same traversal is supplied, every group is prefixed with its byte length.
+    BinaryBackend(Serializer& dest, const SizeTally* tally = nullptr);
+    /// Construct to read from the provided stream, which must outlive the backend. Set lengthPrefixedGroups to match how the data was written.
+    BinaryBackend(Deserializer& source, bool lengthPrefixedGroups = false);
+
+    /// Destruct. In the tagged layout, ends the group on output and skips whatever was not read of it on input.
+    ~BinaryBackend() override;
+
+    /// Returns the name of the backend
+    const String& GetBackendName() override { static const String name("BINARY"); return name; }
+
+    /// Utility method to create an output Archive with a BinaryBackend. Strings can't be interned with a tally, which is measured without interning: the archive then fails every operation.
+    static Archive MakeArchive(Serializer& dest, const SizeTally* tally = nullptr, bool internStrings = false);
+    /// Utility method to create an input Archive with a BinaryBackend. Set internStrings to match how the data was written; length prefixed groups are never interned, so the archive fails every operation with both.
+    static Archive MakeArchive(Deserializer& source, bool lengthPrefixedGroups = false, bool internStrings = false);
+    /// Utility method to create an output Archive with a BinaryBackend using the tagged layout.
+    static Archive MakeTaggedArchive(Serializer& dest, bool internStrings = false);
+    /// Utility method to create an input Archive with a BinaryBackend using the tagged layout. The source must support seeking. Set internStrings to match how the data was written.
+    static Archive MakeTaggedArchive(Deserializer& source, bool internStrings = false);
+    /// Utility method to create an output Archive with a BinaryBackend using the indexed layout.
+    static Archive MakeIndexedArchive(Serializer& dest);
+    /// Utility method to create an input Archive with a BinaryBackend using the indexed layout. The source must support seeking.
+    static Archive MakeIndexedArchive(Deserializer& source);
+
+    /// Utility method that measures the value with a counting pass, then writes it to the buffer with a single allocation. Groups are length-prefixed, so read it back with lengthPrefixedGroups.
+    template<class T>
+    static bool WriteSized(VectorBuffer& dest, const String& name, T& value)
+    {
+        SizeTally tally = SizeCountingBackend::Measure(SizeCountingBackend::FORMAT_BINARY, name, value, true);
+        unsigned start = dest.GetPosition();
+        dest.Resize(start + static_cast<unsigned>(tally.bytes));
+        dest.Seek(start);
+        return MakeArchive(dest, &tally).Serialize(name, value);
+    }
+
+    Backend* CreateGroup(const String &name, bool isInput) override;
+    Backend* CreateSeriesEntry(const String &name, bool isInput) override;
+    /// Only in the indexed layout, for the series whose size was last serialized with this backend. Once the entry closes on input, reading continues after the series.
+    Backend* CreateSeriesEntryAt(const String &name, unsigned index, bool isInput) override;
+    bool GetSeriesSize(const String &name, unsigned &size) override;
+    bool SetSeriesSize(const String &name, const unsigned &size) override;
+    bool GetEntryNames(StringVector &names) override;
+    bool SetEntryNames(const StringVector &names) override;
+    unsigned char InlineSeriesVerbosity() const override { return 0; }
+    bool PrefersBinaryData() const override { return true; }
+    /// The tagged layout only stores scalars, so extended types are archived as groups there.
+    bool SupportsExtendedTypes() const override { return !state_->tagged_; }
+    /// Output always uses the first alternative, so that's the one stored. The tagged layout checks the next entry against the alternatives.
+    unsigned FindEntry(const EntryAlternative* alternatives, unsigned count) override;
+    bool DescribeEntry(const String &name, EntryForm &form, RecordFieldType &type) override;
+    bool SupportsRecords() const override { return true; }
+    bool GetRecord(RecordField* fields, unsigned count) override;
+    bool SetRecord(const RecordField* fields, unsigned count) override;
+    /// Records the condition as one bit of the group's bit block.
+    bool WriteConditional(bool condition, bool isInput) override;
+    /// Records presence as one bit of the group's bit block.
+    bool WritePresence(const String &name, bool present, bool isInput) override;
+
+    /// Nothing is stored for null values, except the tag in the tagged layout.
+    bool Get(const String &name, const std::nullptr_t &) override;
+    bool Get(const String &name, bool &val) override { return state_->tagged_ ? GetScalar(name, val) : ReadBit(val); }
+    bool Get(const String &name, unsigned char &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, signed char &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, unsigned short &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, signed short &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, unsigned int &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, signed int &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, unsigned long long &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, signed long long &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, float &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, double &val) override { return GetScalar(name, val); }
+    bool Get(const String &name, String &val) override;
+    /// Reads a byte buffer with a single read. The tagged layout also accepts a base64 string, as transcoded from JSON.
+    bool Get(const String &name, PODVector<unsigned char> &val) override;
+
+#ifdef EXTENDED_ARCHIVE_TYPES
+    bool Get(const String &, Urho3D::IntVector2 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::IntVector3 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Vector2 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Vector3 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Vector4 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Quaternion &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Color &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Matrix3 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Matrix3x4 &val) override { return !state_->tagged_ && GetPOD(val); }
+    bool Get(const String &, Urho3D::Matrix4 &val) override { return !state_->tagged_ && GetPOD(val); }
+#endif
+
+    bool Set(const String &name, const std::nullptr_t &) override;
+    bool Set(const String &name, const bool &val) override { return state_->tagged_ ? SetScalar(name, val) : WriteBit(val); }
+    bool Set(const String &name, const unsigned char &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const signed char &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const unsigned short &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const signed short &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const unsigned int &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const signed int &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const unsigned long long &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const signed long long &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const float &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const double &val) override { return SetScalar(name, val); }
+    bool Set(const String &name, const String &val) override;
+    /// Writes a byte buffer as its size followed by the bytes with a single write.
+    bool Set(const String &name, const PODVector<unsigned char> &val) override;
+
+#ifdef EXTENDED_ARCHIVE_TYPES
+    bool Set(const String &, const Urho3D::IntVector2 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::IntVector3 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Vector2 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Vector3 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Vector4 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Quaternion &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Color &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Matrix3 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Matrix3x4 &val) override { return !state_->tagged_ && SetPOD(val); }
+    bool Set(const String &, const Urho3D::Matrix4 &val) override { return !state_->tagged_ && SetPOD(val); }
+#endif
+
+private:
+
+    /// Gets a scalar, converting between numeric types in the tagged layout.
+    template<class T>
+    bool GetScalar(const String& name, T& val)
+    {
+        if (!state_->tagged_)
+            return GetPOD(val);
+
+        unsigned char tag;
+        const unsigned char first = std::is_same<T, bool>::value ? RECORD_BOOL : RECORD_UCHAR;
+        const unsigned char last = std::is_same<T, bool>::value ? RECORD_BOOL : RECORD_DOUBLE;
+        if (!MatchHeader(name, tag, first, last))
+            return false;
+
+        switch (tag)
+        {
+        case RECORD_BOOL: return GetAs<bool>(val);
+        case RECORD_UCHAR: return GetAs<unsigned char>(val);
+        case RECORD_SCHAR: return GetAs<signed char>(val);
+        case RECORD_USHORT: return GetAs<unsigned short>(val);
+        case RECORD_SSHORT: return GetAs<signed short>(val);
+        case RECORD_UINT: return GetAs<unsigned int>(val);
+        case RECORD_SINT: return GetAs<signed int>(val);
+        case RECORD_ULONGLONG: return GetAs<unsigned long long>(val);
+        case RECORD_SLONGLONG: return GetAs<signed long long>(val);
+        case RECORD_FLOAT: return GetAs<float>(val);
+        case RECORD_DOUBLE: return GetAs<double>(val);
+        }
+        return false;
+    }
+
+    /// Reads a value stored as Stored into val.
+    template<class Stored, class T>
+    bool GetAs(T& val)
+    {
+        Stored stored;
+        if (!GetPOD(stored))
+            return false;
+        val = static_cast<T>(stored);
+        return true;
+    }
+
+    /// Sets a scalar, preceded by its tag and name in the tagged layout.
+    template<class T>
+    bool SetScalar(const String& name, const T& val)
+    {
+        if (state_->tagged_ && !WriteHeader(RecordFieldTypeOf<T>::value, name))
+            return false;
+        return SetPOD(val);
+    }
+
+    /// Reads the size of a series, and in the indexed layout its offset table.
+    bool ReadSeriesSize(const String& name, unsigned& size, bool indexed);
+    /// Writes the size of a series, and in the indexed layout starts buffering its entries.
+    bool WriteSeriesSize(const String& name, unsigned size, bool indexed);
+    /// Called by an entry of the indexed series when it closes.
+    void EndSeriesEntry();
+    /// Writes the offset table of the indexed series followed by its buffered entries to the series' output.
+    void FlushSeries();
+
+    /// Starts the bit block of a positional group: reads it on input, redirects the output into the group buffer on output.
+    bool BeginBits(bool isInput);
+    /// Writes the bit block of a positional group followed by its buffered contents to the parent's output.
+    void FlushBits();
+    /// Reads the next bit of the group's bit block, or a whole byte outside of groups.
+    bool ReadBit(bool& bit);
+    /// Appends a bit to the group's bit block, or writes a whole byte outside of groups.
+    bool WriteBit(bool bit);
+
+    /// Writes a string value or name: its length and characters, or if interned its ID, preceded by the length and characters on first use.
+    bool WriteString(const String& value);
+    /// Reads a string value or name written by WriteString.
+    bool ReadString(String& value);
+
+    /// Writes the tag and name of an entry in the tagged layout.
+    bool WriteHeader(unsigned char tag, const String& name);
+    /// Reads the tag and name of the next entry in the tagged layout. The name is empty for TAG_END.
+    bool ReadHeader(unsigned char& tag, String& name);
+    /// Finds the offset of the first unread entry of the group in the tagged layout with the name and a tag in [first, last], looking from the next entry on, then from the start of the group. Leaves the stream where it was.
+    bool FindHeader(const String& name, unsigned char first, unsigned char last, unsigned char& tag, unsigned& offset);
+    /// Consumes the header of the entry of the group in the tagged layout with the name and a tag in [first, last], wherever it was stored. Otherwise leaves the stream where it was.
+    bool MatchHeader(const String& name, unsigned char& tag, unsigned char first, unsigned char last);
+    /// Skips the contents of an entry whose header has been read in the tagged layout.
+    bool SkipPayload(unsigned char tag);
+    /// Skips entries up to and including the TAG_END of the current group in the tagged layout.
+    bool SkipToEnd();
+
+    /// Reads the raw bytes of the value. Fails at the end of the stream.
+    template<class T>
+    bool GetPOD(T& val)
+    {
+        if (!state_->source_)
+            return false;
+        return state_->source_->Read(&val, sizeof(T)) == sizeof(T);
+    }
+
+    /// Writes the raw bytes of the value.
+    template<class T>
+    bool SetPOD(const T& val)
+    {
+        if (!state_->dest_)
+            return false;
+        return state_->dest_->Write(&val, sizeof(T)) == sizeof(T);
+    }
+
+    /// The shared stream state.
+    SharedPtr<State> state_;
+    /// True if this backend was created for a group or series entry that ends with TAG_END in the tagged layout.
+    bool closesGroup_{};
+    /// Input offset of the first entry of the group in the tagged layout.
+    unsigned groupStart_{};
+    /// Input offsets of the entries of the group read so far in the tagged layout, so that out of order lookups don't read one twice.
+    HashSet<unsigned> consumed_;
+    /// True once an entry has been read out of order, after which the next entry may already have been read.
+    bool jumped_{};
+    /// Names of the series of the group whose size header has been looked for on input in the tagged layout, so only their first entry looks for it.
+    HashSet<String> seriesSized_;
+    /// Name of the series this backend reads as a group in the tagged layout, whose entries it opens for inline series entries. Empty otherwise.
+    String seriesGroup_;
+    /// Number of entries of that series not opened yet.
+    unsigned seriesGroupLeft_{};
+
+    /// True if this backend was created for a positional group, which has a bit block.
+    bool packsBits_{};
+    /// The packed bits of the group, least significant bit first.
+    PODVector<unsigned char> bits_;
+    /// Number of bits written on output, or stored on input.
+    unsigned bitCount_{};
+    /// Index of the next bit to read on input, or to write when the bits come from the tally.
+    unsigned nextBit_{};
+    /// The group's bits in the tally of the counting pass, when bitsWritten_.
+    const unsigned char* tallyBits_{};
+    /// True once the group's bits have been written from the tally on output, so that its contents aren't buffered.
+    bool bitsWritten_{};
+    /// Buffer holding the contents of the group on output until it closes, when there is no tally.
+    UniquePtr<VectorBuffer> groupBuffer_;
+    /// The output the group is written to when it closes.
+    Serializer* parentDest_{};
+    /// The group that was State::bitsGroup_ when this one began buffering, restored when it closes.
+    BinaryBackend* outerBitsGroup_{};
+
+    /// The indexed series whose size was last serialized with this backend, or null.
+    UniquePtr<IndexedSeries> series_;
+    /// The backend owning the indexed series this entry was created in on output, told when the entry closes.
+    BinaryBackend* seriesOwner_{};
+    /// Input offset to continue from once this entry, opened by index, closes. 0 if none.
+    unsigned seriesEnd_{};
+};
+
+}
+}
@@ -0,0 +1,29 @@
+# Build time cooking of JSON archives into the binary layout read by CookedArchive.
+
+# Cooks JSON archive sources with the ArchiveCook tool and makes the target depend on the result.
+# Each cooked file is written to OUTPUT_DIR at the source's path relative to BASE_DIR with the .cooked extension appended,
+# so adding OUTPUT_DIR as a resource dir lets CookedArchive::Open find it next to the source.
+# Usage: cook_archives (TARGET <target> BASE_DIR <dir> OUTPUT_DIR <dir> SOURCES <file.json>...)
+function (cook_archives)
+    cmake_parse_arguments (ARG "" "TARGET;BASE_DIR;OUTPUT_DIR" "SOURCES" ${ARGN})
+    if (NOT ARG_TARGET OR NOT ARG_BASE_DIR OR NOT ARG_OUTPUT_DIR)
+        message (FATAL_ERROR "cook_archives requires TARGET, BASE_DIR and OUTPUT_DIR.")
+    endif ()
+
+    set (COOKED_FILES)
+    foreach (SOURCE ${ARG_SOURCES})
+        get_filename_component (SOURCE ${SOURCE} ABSOLUTE)
+        file (RELATIVE_PATH RELATIVE ${ARG_BASE_DIR} ${SOURCE})
+        set (COOKED ${ARG_OUTPUT_DIR}/${RELATIVE}.cooked)
+        get_filename_component (COOKED_DIR ${COOKED} DIRECTORY)
+        add_custom_command (OUTPUT ${COOKED}
+            COMMAND ${CMAKE_COMMAND} -E make_directory ${COOKED_DIR}
+            COMMAND ArchiveCook ${SOURCE} ${COOKED}
+            DEPENDS ${SOURCE} ArchiveCook
+            COMMENT "Cooking ${RELATIVE}")
+        list (APPEND COOKED_FILES ${COOKED})
+    endforeach ()
+
+    add_custom_target (${ARG_TARGET}_cook ALL DEPENDS ${COOKED_FILES})
+    add_dependencies (${ARG_TARGET} ${ARG_TARGET}_cook)
+endfunction ()
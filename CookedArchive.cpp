@@ -0,0 +1,91 @@
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include "BinaryBackend.h"
+#include "CookedArchive.h"
+#include "Transcoder.h"
+
+inline namespace Archival {
+
+using namespace Urho3D;
+
+const String CookedArchive::COOKED_EXTENSION{".cooked"};
+const String CookedArchive::COOKED_ID{"ACKD"};
+
+bool CookedArchive::Cook(Context *context, const String &sourceName, const String &cookedName)
+{
+    File source(context, sourceName, FILE_READ);
+    if (!source.IsOpen())
+        return false;
+    unsigned checksum = source.GetChecksum();
+    source.Seek(0);
+
+    JSONFile json(context);
+    if (!json.Load(source))
+        return false;
+
+    File cooked(context, cookedName, FILE_WRITE);
+    if (!cooked.IsOpen())
+        return false;
+    cooked.WriteFileID(COOKED_ID);
+    cooked.WriteUInt(COOKED_VERSION);
+    cooked.WriteUInt(checksum);
+
+    Archive input = Detail::JSONBackend::MakeArchive(true, json.GetRoot());
+    Archive output = Detail::BinaryBackend::MakeTaggedArchive(cooked);
+    return Transcoder::Transcode(input, output);
+}
+
+bool CookedArchive::Open(const String &sourceName)
+{
+    archive_.Reset();
+    json_.Reset();
+    file_.Reset();
+    cooked_ = false;
+
+    SharedPtr<File> source = OpenFile(sourceName);
+    if (SharedPtr<File> cooked = OpenFile(sourceName + COOKED_EXTENSION))
+    {
+        // Hashing the source is far cheaper than parsing it.
+        unsigned sourceChecksum;
+        if (ReadHeader(*cooked, sourceChecksum) && (!source || source->GetChecksum() == sourceChecksum))
+        {
+            file_ = cooked;
+            cooked_ = true;
+            archive_.Reset(new Archive(Detail::BinaryBackend::MakeTaggedArchive(*file_)));
+            return true;
+        }
+        URHO3D_LOGDEBUG("Ignoring stale cooked file for " + sourceName);
+    }
+
+    if (!source)
+        return false;
+    file_ = source;
+    json_ = new JSONFile(context_);
+    if (!json_->Load(*file_))
+        return false;
+    archive_.Reset(new Archive(Detail::JSONBackend::MakeArchive(true, json_->GetRoot())));
+    return true;
+}
+
+SharedPtr<File> CookedArchive::OpenFile(const String &name) const
+{
+    if (auto* cache = context_->GetSubsystem<ResourceCache>())
+        return cache->GetFile(name, false);
+
+    auto* fileSystem = context_->GetSubsystem<FileSystem>();
+    if (fileSystem && !fileSystem->FileExists(name))
+        return SharedPtr<File>();
+    SharedPtr<File> file(new File(context_, name, FILE_READ));
+    return file->IsOpen() ? file : SharedPtr<File>();
+}
+
+bool CookedArchive::ReadHeader(File &cooked, unsigned &sourceChecksum)
+{
+    if (cooked.GetSize() < 12 || cooked.ReadFileID() != COOKED_ID || cooked.ReadUInt() != COOKED_VERSION)
+        return false;
+    sourceChecksum = cooked.ReadUInt();
+    return true;
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/Resource/JSONFile.h>
+
+#include "Archive.h"
+
+inline namespace Archival {
+
+/// Opens input archives for JSON sources, transparently preferring the binary cooked from the same source at build time (ArchiveCook, see cook_archives in CMake/Modules/ArchiveCooking.cmake).
+/// A cooked file starts with a header holding the checksum of the source it was cooked from, followed by the tagged BinaryBackend layout, so the same ArchiveValue code reads either.
+class CookedArchive
+{
+public:
+    /// Extension appended to the source name to find its cooked file.
+    static const String COOKED_EXTENSION;
+    /// File ID at the start of a cooked file.
+    static const String COOKED_ID;
+    /// Version of the cooked header, bumped whenever the layout changes so that stale cooked files are ignored.
+    static constexpr unsigned COOKED_VERSION{1};
+
+    /// Construct. Files are opened through the ResourceCache if the context has one.
+    explicit CookedArchive(Urho3D::Context* context): context_(context) {}
+
+    /// Cooks the JSON source file into the cooked file. Returns false if the source can't be parsed or the cooked file can't be written.
+    static bool Cook(Urho3D::Context* context, const String& sourceName, const String& cookedName);
+
+    /// Opens the source for input. Uses the cooked file (sourceName + COOKED_EXTENSION) if it was cooked from the current source, or if only the cooked file was shipped; otherwise parses the JSON.
+    bool Open(const String& sourceName);
+
+    /// Returns the input archive. Only valid after a successful Open.
+    Archive& GetArchive() { assert(archive_); return *archive_; }
+    /// Returns true if the archive reads from the cooked file.
+    bool IsCooked() const { return cooked_; }
+
+private:
+    /// Opens a file for reading, through the ResourceCache if there is one. Returns null if it doesn't exist.
+    Urho3D::SharedPtr<Urho3D::File> OpenFile(const String& name) const;
+    /// Reads the cooked header and returns true if the file is a cooked file of the current version, also returning the checksum of its source.
+    static bool ReadHeader(Urho3D::File& cooked, unsigned& sourceChecksum);
+
+    /// Context to open files with.
+    Urho3D::Context* context_;
+    /// The file being read, cooked or source.
+    Urho3D::SharedPtr<Urho3D::File> file_;
+    /// The parsed source when not reading the cooked file.
+    Urho3D::SharedPtr<Urho3D::JSONFile> json_;
+    /// The input archive. Declared last so it is destroyed before what it reads from.
+    Urho3D::UniquePtr<Archive> archive_;
+    /// True if reading the cooked file.
+    bool cooked_{};
+};
+
+}
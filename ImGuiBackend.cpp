@@ -18,11 +18,8 @@ struct ImGuiID
     ~ImGuiID() { ImGui::PopID(); }
 };
 
-int ImGuiBackend::globalTreeDepth_ = -1;
-Vector<String> ImGuiBackend::lastTreeNames_;
-
-ImGuiBackend::ImGuiBackend(const String &groupName, unsigned treeDepth, int seriesEntry)
-    : seriesEntry_(seriesEntry), myTreeDepth_(treeDepth), myTreeName_(groupName)
+ImGuiBackend::ImGuiBackend(const String &groupName, unsigned treeDepth, int seriesEntry, TreeState *tree)
+    : seriesEntry_(seriesEntry), myTreeDepth_(treeDepth), myTreeName_(groupName), tree_(tree ? tree : new TreeState())
 {
     if (myTreeDepth_ == 0)//!windowName_.Empty())
     {
@@ -48,8 +45,8 @@ ImGuiBackend::~ImGuiBackend()
     // A bit of cleaning up.
     if (myTreeDepth_ == 0)//!windowName_.Empty())
     {
-        while (lastTreeNames_.Size()) {
-            lastTreeNames_.Pop();
+        while (tree_->names_.Size()) {
+            tree_->names_.Pop();
             ImGui::PopID();
         }
         ImGui::End();
@@ -136,13 +133,13 @@ Backend *ImGuiBackend::CreateGroup(const String &name, bool isInput)
     if (!isInput)
         return nullptr;
 
-    if (name == InlineName())
-        return new ImGuiBackend(name, myTreeDepth_+1, seriesEntry_);
+    if (IsInline(name))
+        return new ImGuiBackend(name, myTreeDepth_+1, seriesEntry_, tree_);
     else
     {
         ImGuiID raii(seriesEntry_);
-        if (ImGui::CollapsingHeader(name.CString(), ImGuiTreeNodeFlags_DefaultOpen))
-            return new ImGuiBackend(name, myTreeDepth_+1, seriesEntry_);
+        if (ImGui::CollapsingHeader(KeyName(name).CString(), ImGuiTreeNodeFlags_DefaultOpen))
+            return new ImGuiBackend(name, myTreeDepth_+1, seriesEntry_, tree_);
         else
             return new NoOpBackend();
     }
@@ -169,12 +166,12 @@ Backend *ImGuiBackend::CreateSeriesEntry(const String &name, bool isInput)
     if (lastSeriesName_ != name)
     {
         lastSeriesName_ = name;
-        lastSeriesOpen_ = ImGui::CollapsingHeader(name.CString(), ImGuiTreeNodeFlags_DefaultOpen);
+        lastSeriesOpen_ = ImGui::CollapsingHeader(KeyName(name).CString(), ImGuiTreeNodeFlags_DefaultOpen);
     }
 
     if (lastSeriesOpen_)
     {
-        ImGui::TextColored({1,0,0,1}, "%s[%d]",name.CString(),entries_[name]);
+        ImGui::TextColored({1,0,0,1}, "%s[%d]",KeyName(name).CString(),entries_[name]);
 
         ImGui::SameLine();
 
@@ -183,7 +180,7 @@ Backend *ImGuiBackend::CreateSeriesEntry(const String &name, bool isInput)
         ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)ImColor::HSV(hue, 0.7f, 0.7f));
         ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)ImColor::HSV(hue, 0.8f, 0.8f));
         BeginValue();
-        ImGui::PushID(name.CString());
+        ImGui::PushID(KeyName(name).CString());
         ImGui::PushID(entries_[name]);
         bool shouldClose = ImGui::Button("X");
         if (shouldClose)
@@ -197,7 +194,7 @@ Backend *ImGuiBackend::CreateSeriesEntry(const String &name, bool isInput)
 
         if (shouldClose)
             return {};
-        return new ImGuiBackend(name, myTreeDepth_+1, entries_[name]);
+        return new ImGuiBackend(name, myTreeDepth_+1, entries_[name], tree_);
     }
     else
         return nullptr;
@@ -208,12 +205,12 @@ bool ImGuiBackend::GetSeriesSize(const String &name, unsigned &size)
     if (lastSeriesName_ != name)
     {
         lastSeriesName_ = name;
-        lastSeriesOpen_ = ImGui::CollapsingHeader(ToString("%s <%d>",name.CString(), size).CString(), ImGuiTreeNodeFlags_DefaultOpen);
+        lastSeriesOpen_ = ImGui::CollapsingHeader(ToString("%s <%d>",KeyName(name).CString(), size).CString(), ImGuiTreeNodeFlags_DefaultOpen);
 
         if (lastSeriesOpen_)
         {
             BeginValue();
-            ImGui::PushID(name.CString());
+            ImGui::PushID(KeyName(name).CString());
 //            ImGui::PushID(seriesEntry_);
 
             float hue = 1.f/3;
@@ -253,7 +250,7 @@ bool ImGuiBackend::GetSeriesSize(const String &name, unsigned &size)
 bool ImGuiBackend::Get(const String &name, const std::nullptr_t &)
 {
     BeginValue();
-    ImGui::TextDisabled("%s (null)",name.CString());
+    ImGui::TextDisabled("%s (null)",KeyName(name).CString());
     EndValue();
     return true;
 }
@@ -261,7 +258,7 @@ bool ImGuiBackend::Get(const String &name, const std::nullptr_t &)
 bool ImGuiBackend::Get(const String &name, bool &val)
 {
     BeginValue();
-    ImGui::Checkbox(name.CString(), &val);
+    ImGui::Checkbox(KeyName(name).CString(), &val);
     EndValue();
     return true;
 }
@@ -270,8 +267,8 @@ bool ImGuiBackend::Get(const String &name, unsigned char &val)
 {
     BeginValue();
     unsigned extended = val;
-    unsigned char min = 0, max = 0xff;
-    ImGui::DragScalar(name.CString(), ImGuiDataType_U32, &extended, GetSpeedHint(), &min, &max);
+    unsigned min = 0, max = 0xff;
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_U32, &extended, GetSpeedHint(), &min, &max);
     val = static_cast<unsigned char>(extended);
     EndValue();
     return true;
@@ -280,11 +277,11 @@ bool ImGuiBackend::Get(const String &name, unsigned char &val)
 bool ImGuiBackend::Get(const String &name, signed char &val)
 {
     BeginValue();
-    static int extended;
-    extended = val;
+    // DragScalar reads the bounds as the data type, so they are widened along with the value.
+    int extended = val;
     using type = std::decay<decltype(val)>::type;
-    type min = std::numeric_limits<type>::min(), max = std::numeric_limits<type>::max();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_S32, &extended, GetSpeedHint(), &min, &max);
+    int min = std::numeric_limits<type>::min(), max = std::numeric_limits<type>::max();
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_S32, &extended, GetSpeedHint(), &min, &max);
     val = static_cast<signed char>(extended);
     EndValue();
     return true;
@@ -293,10 +290,9 @@ bool ImGuiBackend::Get(const String &name, signed char &val)
 bool ImGuiBackend::Get(const String &name, unsigned short &val)
 {
     BeginValue();
-    static unsigned extended;
-    extended = val;
-    unsigned short min = 0, max = 0xffff;
-    ImGui::DragScalar(name.CString(), ImGuiDataType_U32, &extended, GetSpeedHint(), &min, &max);
+    unsigned extended = val;
+    unsigned min = 0, max = 0xffff;
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_U32, &extended, GetSpeedHint(), &min, &max);
     val = static_cast<unsigned short>(extended);
     EndValue();
     return true;
@@ -305,11 +301,11 @@ bool ImGuiBackend::Get(const String &name, unsigned short &val)
 bool ImGuiBackend::Get(const String &name, signed short &val)
 {
     BeginValue();
-    static int extended;
-    extended = val;
+    // DragScalar reads the bounds as the data type, so they are widened along with the value.
+    int extended = val;
     using type = std::decay<decltype(val)>::type;
-    type min = std::numeric_limits<type>::min(), max = std::numeric_limits<type>::max();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_S32, &extended, GetSpeedHint(), &min, &max);
+    int min = std::numeric_limits<type>::min(), max = std::numeric_limits<type>::max();
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_S32, &extended, GetSpeedHint(), &min, &max);
     val = static_cast<short>(extended);
     EndValue();
     return true;
@@ -318,7 +314,7 @@ bool ImGuiBackend::Get(const String &name, signed short &val)
 bool ImGuiBackend::Get(const String &name, unsigned int &val)
 {
     BeginValue();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_U32, &val, GetSpeedHint());
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_U32, &val, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -326,7 +322,7 @@ bool ImGuiBackend::Get(const String &name, unsigned int &val)
 bool ImGuiBackend::Get(const String &name, signed int &val)
 {
     BeginValue();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_S32, &val, GetSpeedHint());
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_S32, &val, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -334,7 +330,7 @@ bool ImGuiBackend::Get(const String &name, signed int &val)
 bool ImGuiBackend::Get(const String &name, unsigned long long &val)
 {
     BeginValue();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_U64, &val, GetSpeedHint());
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_U64, &val, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -342,7 +338,7 @@ bool ImGuiBackend::Get(const String &name, unsigned long long &val)
 bool ImGuiBackend::Get(const String &name, signed long long &val)
 {
     BeginValue();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_S64, &val, GetSpeedHint());
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_S64, &val, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -355,7 +351,7 @@ bool ImGuiBackend::Get(const String &name, float &val)
 
 //    ImGui::SliderFloat(name.CString(), &val, -100, 100);
 //    ImGui::DragFloat(name.CString(), &val, 0.1f, -100, 100);
-    ImGui::DragFloat(name.CString(), &val, 0.1f);
+    ImGui::DragFloat(KeyName(name).CString(), &val, 0.1f);
 
 
 //    ImGui::SetNextWindowSize(ImVec2(200,200), ImGuiCond_FirstUseEver);
@@ -372,7 +368,7 @@ bool ImGuiBackend::Get(const String &name, float &val)
 bool ImGuiBackend::Get(const String &name, double &val)
 {
     BeginValue();
-    ImGui::DragScalar(name.CString(), ImGuiDataType_Double, &val, GetSpeedHint());
+    ImGui::DragScalar(KeyName(name).CString(), ImGuiDataType_Double, &val, GetSpeedHint());
 //    ImGui::InputDouble(name.CString(), &val);
     EndValue();
     return true;
@@ -401,7 +397,7 @@ bool ImGuiBackend::Get(const String &name, String &val)
             if (current == values.Size())
                 break;
 
-            if (ImGui::BeginCombo(name.CString(), val.CString(), 0)) // The second parameter is the label previewed before opening the combo.
+            if (ImGui::BeginCombo(KeyName(name).CString(), val.CString(), 0)) // The second parameter is the label previewed before opening the combo.
             {
                 for (unsigned n = 0; n < values.Size(); n++)
                 {
@@ -420,7 +416,7 @@ bool ImGuiBackend::Get(const String &name, String &val)
         }
     } while (false);
 
-    ImGui::InputText(name.CString(), &val);
+    ImGui::InputText(KeyName(name).CString(), &val);
     EndValue();
     return true;
 }
@@ -428,7 +424,7 @@ bool ImGuiBackend::Get(const String &name, String &val)
 bool ImGuiBackend::Get(const String &name, IntVector2 &val)
 {
     BeginValue();
-    ImGui::DragInt2(name.CString(), &val.x_, GetSpeedHint());
+    ImGui::DragInt2(KeyName(name).CString(), &val.x_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -436,7 +432,7 @@ bool ImGuiBackend::Get(const String &name, IntVector2 &val)
 bool ImGuiBackend::Get(const String &name, IntVector3 &val)
 {
     BeginValue();
-    ImGui::DragInt3(name.CString(), &val.x_, GetSpeedHint());
+    ImGui::DragInt3(KeyName(name).CString(), &val.x_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -444,7 +440,7 @@ bool ImGuiBackend::Get(const String &name, IntVector3 &val)
 bool ImGuiBackend::Get(const String &name, Vector2 &val)
 {
     BeginValue();
-    ImGui::DragFloat2(name.CString(), &val.x_, GetSpeedHint());
+    ImGui::DragFloat2(KeyName(name).CString(), &val.x_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -452,7 +448,7 @@ bool ImGuiBackend::Get(const String &name, Vector2 &val)
 bool ImGuiBackend::Get(const String &name, Vector3 &val)
 {
     BeginValue();
-    ImGui::DragFloat3(name.CString(), &val.x_, GetSpeedHint());
+    ImGui::DragFloat3(KeyName(name).CString(), &val.x_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -460,7 +456,7 @@ bool ImGuiBackend::Get(const String &name, Vector3 &val)
 bool ImGuiBackend::Get(const String &name, Vector4 &val)
 {
     BeginValue();
-    ImGui::DragFloat4(name.CString(), &val.x_, GetSpeedHint());
+    ImGui::DragFloat4(KeyName(name).CString(), &val.x_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -472,7 +468,7 @@ bool ImGuiBackend::Get(const String &name, Quaternion &val)
     // Create 3d gizmo to edit the quaternion
     vgm::Quat tmp(val.w_,val.x_, val.y_, val.z_);
     tmp = normalize(tmp);
-    if(ImGui::gizmo3D((name + "-Gizmo-" + name).CString(), tmp))  {
+    if(ImGui::gizmo3D((KeyName(name) + "-Gizmo-" + KeyName(name)).CString(), tmp))  {
         val.w_ = tmp.w;
         val.x_ = tmp.x;
         val.y_ = tmp.y;
@@ -501,7 +497,7 @@ bool ImGuiBackend::Get(const String &name, Quaternion &val)
 bool ImGuiBackend::Get(const String &name, Color &val)
 {
     BeginValue();
-    ImGui::ColorEdit4(name.CString(), &val.r_, ImGuiColorEditFlags_RGB
+    ImGui::ColorEdit4(KeyName(name).CString(), &val.r_, ImGuiColorEditFlags_RGB
                       | ImGuiColorEditFlags_Float | ImGuiColorEditFlags_PickerHueWheel);
     EndValue();
     return true;
@@ -510,9 +506,9 @@ bool ImGuiBackend::Get(const String &name, Color &val)
 bool ImGuiBackend::Get(const String &name, Matrix3 &val)
 {
     BeginValue();
-    ImGui::DragFloat3((name + ":R0").CString(), &val.m00_, GetSpeedHint());
-    ImGui::DragFloat3((name + ":R1").CString(), &val.m10_, GetSpeedHint());
-    ImGui::DragFloat3((name + ":R2").CString(), &val.m20_, GetSpeedHint());
+    ImGui::DragFloat3((KeyName(name) + ":R0").CString(), &val.m00_, GetSpeedHint());
+    ImGui::DragFloat3((KeyName(name) + ":R1").CString(), &val.m10_, GetSpeedHint());
+    ImGui::DragFloat3((KeyName(name) + ":R2").CString(), &val.m20_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -520,9 +516,9 @@ bool ImGuiBackend::Get(const String &name, Matrix3 &val)
 bool ImGuiBackend::Get(const String &name, Matrix3x4 &val)
 {
     BeginValue();
-    ImGui::DragFloat4((name + ":R0").CString(), &val.m00_, GetSpeedHint());
-    ImGui::DragFloat4((name + ":R1").CString(), &val.m10_, GetSpeedHint());
-    ImGui::DragFloat4((name + ":R2").CString(), &val.m20_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R0").CString(), &val.m00_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R1").CString(), &val.m10_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R2").CString(), &val.m20_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -530,10 +526,10 @@ bool ImGuiBackend::Get(const String &name, Matrix3x4 &val)
 bool ImGuiBackend::Get(const String &name, Matrix4 &val)
 {
     BeginValue();
-    ImGui::DragFloat4((name + ":R0").CString(), &val.m00_, GetSpeedHint());
-    ImGui::DragFloat4((name + ":R1").CString(), &val.m10_, GetSpeedHint());
-    ImGui::DragFloat4((name + ":R2").CString(), &val.m20_, GetSpeedHint());
-    ImGui::DragFloat4((name + ":R3").CString(), &val.m30_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R0").CString(), &val.m00_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R1").CString(), &val.m10_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R2").CString(), &val.m20_, GetSpeedHint());
+    ImGui::DragFloat4((KeyName(name) + ":R3").CString(), &val.m30_, GetSpeedHint());
     EndValue();
     return true;
 }
@@ -545,34 +541,34 @@ bool Archival::Detail::ImGuiBackend::WriteConditional(bool condition, bool isInp
 
 void ImGuiBackend::BeginValue()
 {
-    if (myTreeDepth_+1 < (int)lastTreeNames_.Size())
+    if (myTreeDepth_+1 < (int)tree_->names_.Size())
     {
-        while (myTreeDepth_+1 < (int)lastTreeNames_.Size())
+        while (myTreeDepth_+1 < (int)tree_->names_.Size())
         {
             ImGui::PopID();
-            globalTreeDepth_--;
-            lastTreeNames_.Pop();
+            tree_->depth_--;
+            tree_->names_.Pop();
         }
     }
 
-    if (myTreeDepth_+1 == (int)lastTreeNames_.Size())
+    if (myTreeDepth_+1 == (int)tree_->names_.Size())
     {
-        if (myTreeName_ != lastTreeNames_[myTreeDepth_])
+        if (myTreeName_ != tree_->names_[myTreeDepth_])
         {
             ImGui::PopID();
             ImGui::PushID(myTreeName_.CString());
-            lastTreeNames_[myTreeDepth_] = myTreeName_;
+            tree_->names_[myTreeDepth_] = myTreeName_;
         }
     }
-    else if (myTreeDepth_+1 > (int)lastTreeNames_.Size())
+    else if (myTreeDepth_+1 > (int)tree_->names_.Size())
     {
-        assert (myTreeDepth_ == (int)lastTreeNames_.Size());
+        assert (myTreeDepth_ == (int)tree_->names_.Size());
         ImGui::PushID(myTreeName_.CString());
-        lastTreeNames_.Push(myTreeName_);
-        globalTreeDepth_++;
+        tree_->names_.Push(myTreeName_);
+        tree_->depth_++;
     }
 
-    assert(myTreeDepth_+1 == (int)lastTreeNames_.Size());
+    assert(myTreeDepth_+1 == (int)tree_->names_.Size());
 
     if (seriesEntry_ != INVALID_SERIES_ENTRY)
         ImGui::PushID(seriesEntry_);
@@ -23,8 +23,17 @@ class ImGuiBackend: public Backend
     /// The name "value" is reserved. It is used to handle the case of inline values (like JSON [1,2,3]).
 
 
-    /// Internal constructor that is used for CreateGroup/SeriesEntry for non-root groups in the tree. Takes the name of the node, the depth in the tree, and the series entry if it was an entry in a series element rather than a group.
-    ImGuiBackend(const String& groupName, unsigned treeDepth, int seriesEntry);
+    /// The ImGui ID stack of the tree of backends under a window, shared by every backend in it.
+    struct TreeState: public RefCounted
+    {
+        /// Holds the current tree depth so we know how many times to PopID from the stack.
+        int depth_{-1};
+        /// Holds the current tree-name stack so we know what to pop from the tree.
+        StringVector names_;
+    };
+
+    /// Internal constructor that is used for CreateGroup/SeriesEntry for non-root groups in the tree. Takes the name of the node, the depth in the tree, the series entry if it was an entry in a series element rather than a group, and the tree's state (created for the root).
+    ImGuiBackend(const String& groupName, unsigned treeDepth, int seriesEntry, TreeState* tree = nullptr);
 
 public:
 
@@ -54,6 +63,7 @@ public:
     bool GetEntryNames(StringVector &) override { return true; /* we don't need to pre-serialize names */}
     bool SetEntryNames(const StringVector &) override { return false; /* we do not support setting values */ }
     unsigned char InlineSeriesVerbosity() const override { return 20; }
+    bool SupportsExtendedTypes() const override { return true; }
 
     bool Get(const String &name, const std::nullptr_t &) override;
     bool Get(const String &name, bool &val) override;
@@ -151,10 +161,8 @@ private:
     /// String that is the name of the element (node for the tree or window title).
     String myTreeName_;
 
-    /// Holds the current global tree depth so we know how many times to PopID from the stack.
-    static int globalTreeDepth_;
-    /// Holds the current tree-name stack so we know what to pop from the tree.
-    static StringVector lastTreeNames_;
+    /// ID stack state of the tree this backend belongs to. Per window rather than global, so separate windows don't share it.
+    SharedPtr<TreeState> tree_;
 
     /// Method to be called before a value is written to IMGUI to set up the necessary IDs on the stack and such.
     void BeginValue();
@@ -0,0 +1,21 @@
+#include "JSONDocument.h"
+
+inline namespace Archival {
+
+std::shared_ptr<const JSONDocument> JSONDocument::Parse(Urho3D::Context *context, const String &text)
+{
+    Urho3D::SharedPtr<Urho3D::JSONFile> file(new Urho3D::JSONFile(context));
+    if (!file->FromString(text))
+        return nullptr;
+    return std::make_shared<const JSONDocument>(file);
+}
+
+std::shared_ptr<const JSONDocument> JSONDocument::Load(Urho3D::Context *context, Urho3D::Deserializer &source)
+{
+    Urho3D::SharedPtr<Urho3D::JSONFile> file(new Urho3D::JSONFile(context));
+    if (!file->Load(source))
+        return nullptr;
+    return std::make_shared<const JSONDocument>(file);
+}
+
+}
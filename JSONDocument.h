@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Resource/JSONFile.h>
+
+#include <memory>
+
+#include "Archive.h"
+
+inline namespace Archival {
+
+/// A parsed JSON document that is never modified after parsing, so any number of threads can read it at once without copying or locking, e.g. to instantiate many objects from one definition.
+/// Every archive made from it is an input archive whose JSONBackend only reads. The document is shared through std::shared_ptr, whose count (unlike RefCounted's) is safe to share across threads.
+class JSONDocument
+{
+public:
+    /// Parses the text. Returns null if it isn't valid JSON.
+    static std::shared_ptr<const JSONDocument> Parse(Urho3D::Context* context, const String& text);
+    /// Parses the contents of the stream. Returns null if it isn't valid JSON.
+    static std::shared_ptr<const JSONDocument> Load(Urho3D::Context* context, Urho3D::Deserializer& source);
+
+    /// Construct from a parsed JSONFile, which the document takes over: it must not be modified or reloaded afterwards.
+    explicit JSONDocument(Urho3D::SharedPtr<Urho3D::JSONFile> file): file_(std::move(file)) {}
+
+    /// Returns the root value.
+    const Urho3D::JSONValue& GetRoot() const { return file_->GetRoot(); }
+    /// Creates an input archive reading the document. Thread safe. The document must outlive the archive and the groups created from it.
+    Archive MakeArchive() const { return Detail::JSONBackend::MakeArchive(GetRoot()); }
+
+private:
+    /// The file holding the parsed values. Its RefCounted count is only touched by the document itself.
+    Urho3D::SharedPtr<Urho3D::JSONFile> file_;
+};
+
+}
@@ -0,0 +1,145 @@
+#include <Urho3D/Graphics/Technique.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Graphics/Texture2DArray.h>
+#include <Urho3D/Graphics/Texture3D.h>
+#include <Urho3D/Graphics/TextureCube.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include "ArchiveUrhoTypes.h"
+#include "MaterialArchive.h"
+
+inline namespace Archival {
+
+using namespace Urho3D;
+
+MaterialDescription MaterialArchive::Describe(const Material &material)
+{
+    MaterialDescription description;
+    description.vsDefines_ = material.GetVertexShaderDefines();
+    description.psDefines_ = material.GetPixelShaderDefines();
+
+    for (const TechniqueEntry& entry : material.GetTechniques())
+        if (entry.original_)
+            description.techniques_.Push({entry.original_->GetName(), static_cast<unsigned char>(entry.qualityLevel_), entry.lodDistance_});
+    for (const auto& texture : material.GetTextures())
+        if (texture.second_)
+            description.textures_.Push({static_cast<unsigned char>(texture.first_), texture.second_->GetName(), texture.second_->GetType()});
+    for (const auto& parameter : material.GetShaderParameters())
+        description.parameters_.Push({parameter.second_.name_, parameter.second_.value_});
+
+    description.cullMode_ = material.GetCullMode();
+    description.shadowCullMode_ = material.GetShadowCullMode();
+    description.fillMode_ = material.GetFillMode();
+    description.constantBias_ = material.GetDepthBias().constantBias_;
+    description.slopeScaledBias_ = material.GetDepthBias().slopeScaledBias_;
+    description.alphaToCoverage_ = material.GetAlphaToCoverage();
+    description.lineAntiAlias_ = material.GetLineAntiAlias();
+    description.renderOrder_ = material.GetRenderOrder();
+    description.occlusion_ = material.GetOcclusion();
+    return description;
+}
+
+/// Resolves the texture type from the name as Material::Load does: cube maps, 3D textures and arrays are defined by an XML file.
+static StringHash ResolveTextureType(ResourceCache* cache, const String& name, TextureUnit unit)
+{
+    if (GetExtension(name) != ".xml")
+        return Texture2D::GetTypeStatic();
+#ifdef DESKTOP_GRAPHICS
+    StringHash type = ParseTextureTypeXml(cache, name);
+    if (!type && unit == TU_VOLUMEMAP)
+        type = Texture3D::GetTypeStatic();
+    if (type == Texture3D::GetTypeStatic() || type == Texture2DArray::GetTypeStatic())
+        return type;
+#endif
+    return TextureCube::GetTypeStatic();
+}
+
+bool MaterialArchive::BeginLoad(Archive &ar, const String &name, MaterialDescription &description, ResourceCache *cache)
+{
+    if (!ar.Serialize(name, description))
+        return false;
+
+    for (const MaterialTechnique& technique : description.techniques_)
+        cache->BackgroundLoadResource<Technique>(technique.name_);
+    for (MaterialTexture& texture : description.textures_)
+    {
+        if (texture.unit_ >= MAX_TEXTURE_UNITS)
+            continue;
+        texture.type_ = ResolveTextureType(cache, texture.name_, static_cast<TextureUnit>(texture.unit_));
+        cache->BackgroundLoadResource(texture.type_, texture.name_);
+    }
+    return true;
+}
+
+void MaterialArchive::EndLoad(Material &material, const MaterialDescription &description)
+{
+    auto* cache = material.GetSubsystem<ResourceCache>();
+
+    // Sorted the way Material::SortTechniques does, as Material only sorts in Load.
+    PODVector<const MaterialTechnique*> techniques;
+    for (const MaterialTechnique& technique : description.techniques_)
+        techniques.Push(&technique);
+    Sort(techniques.Begin(), techniques.End(), [](const MaterialTechnique* lhs, const MaterialTechnique* rhs)
+    {
+        return lhs->lodDistance_ != rhs->lodDistance_ ? lhs->lodDistance_ > rhs->lodDistance_ : lhs->quality_ > rhs->quality_;
+    });
+
+    // Missing techniques are left out. The resource cache has already logged them.
+    PODVector<Technique*> loaded;
+    for (const MaterialTechnique* technique : techniques)
+        loaded.Push(cache->GetResource<Technique>(technique->name_));
+    unsigned count = 0;
+    for (Technique* technique : loaded)
+        count += technique != nullptr;
+    material.SetNumTechniques(count);
+    for (unsigned i = 0, index = 0; i < loaded.Size(); ++i)
+        if (loaded[i])
+            material.SetTechnique(index++, loaded[i], static_cast<MaterialQuality>(techniques[i]->quality_), techniques[i]->lodDistance_);
+
+    // After the techniques, so that the defines are applied to them.
+    material.SetVertexShaderDefines(description.vsDefines_);
+    material.SetPixelShaderDefines(description.psDefines_);
+
+    for (const MaterialTexture& texture : description.textures_)
+    {
+        if (texture.unit_ >= MAX_TEXTURE_UNITS)
+            continue;
+        StringHash type = texture.type_ ? texture.type_ : ResolveTextureType(cache, texture.name_, static_cast<TextureUnit>(texture.unit_));
+        material.SetTexture(static_cast<TextureUnit>(texture.unit_), static_cast<Texture*>(cache->GetResource(type, texture.name_)));
+    }
+    for (const MaterialParameter& parameter : description.parameters_)
+        material.SetShaderParameter(parameter.name_, parameter.value_);
+
+    material.SetCullMode(static_cast<CullMode>(description.cullMode_));
+    material.SetShadowCullMode(static_cast<CullMode>(description.shadowCullMode_));
+    material.SetFillMode(static_cast<FillMode>(description.fillMode_));
+    material.SetDepthBias(BiasParameters(description.constantBias_, description.slopeScaledBias_));
+    material.SetAlphaToCoverage(description.alphaToCoverage_);
+    material.SetLineAntiAlias(description.lineAntiAlias_);
+    material.SetRenderOrder(description.renderOrder_);
+    material.SetOcclusion(description.occlusion_);
+}
+
+}
+
+namespace Urho3D
+{
+
+ArchiveResult<Archive, Material> ArchiveValue(Archive &archive, const String &name, Material &self)
+{
+    MaterialDescription description;
+    if (!archive.IsInput())
+    {
+        description = MaterialArchive::Describe(self);
+        return {archive, archive.Serialize(name, description), self};
+    }
+
+    // Even loading synchronously, every resource is queued before the first is waited for.
+    if (!MaterialArchive::BeginLoad(archive, name, description, self.GetSubsystem<ResourceCache>()))
+        return {archive, false, self};
+    MaterialArchive::EndLoad(self, description);
+    return {archive, true, self};
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Urho3D/Graphics/Material.h>
+
+#include "ArchiveUrhoTypes.h"
+
+namespace Urho3D
+{
+class ResourceCache;
+}
+
+inline namespace Archival {
+
+/// A technique of an archived material.
+struct MaterialTechnique
+{
+    String name_;
+    unsigned char quality_{Urho3D::QUALITY_LOW};
+    float lodDistance_{};
+
+    ARCHIVE_FIELDS(MaterialTechnique, ARCHIVE_FIELD_NAMED("name", name_), ARCHIVE_FIELD_NAMED("quality", quality_), ARCHIVE_FIELD_NAMED("loddistance", lodDistance_))
+};
+
+/// A texture of an archived material. The texture type is not archived, it is resolved from the name when loading.
+struct MaterialTexture
+{
+    unsigned char unit_{};
+    String name_;
+    /// Resolved texture type.
+    Urho3D::StringHash type_;
+
+    ARCHIVE_FIELDS(MaterialTexture, ARCHIVE_FIELD_NAMED("unit", unit_), ARCHIVE_FIELD_NAMED("name", name_))
+};
+
+/// A shader parameter of an archived material.
+struct MaterialParameter
+{
+    String name_;
+    Urho3D::Variant value_;
+
+    ARCHIVE_FIELDS(MaterialParameter, ARCHIVE_FIELD_NAMED("name", name_), ARCHIVE_FIELD_NAMED("value", value_))
+};
+
+/// Plain data of a Material that references its techniques and textures by name, so it can be archived away from the main thread.
+struct MaterialDescription
+{
+    String vsDefines_;
+    String psDefines_;
+    Urho3D::Vector<MaterialTechnique> techniques_;
+    Urho3D::Vector<MaterialTexture> textures_;
+    Urho3D::Vector<MaterialParameter> parameters_;
+    unsigned char cullMode_{Urho3D::CULL_CCW};
+    unsigned char shadowCullMode_{Urho3D::CULL_CCW};
+    unsigned char fillMode_{Urho3D::FILL_SOLID};
+    float constantBias_{};
+    float slopeScaledBias_{};
+    bool alphaToCoverage_{};
+    bool lineAntiAlias_{};
+    unsigned char renderOrder_{Urho3D::DEFAULT_RENDER_ORDER};
+    bool occlusion_{true};
+
+    ARCHIVE_FIELDS(MaterialDescription, ARCHIVE_FIELD_NAMED("vsdefines", vsDefines_), ARCHIVE_FIELD_NAMED("psdefines", psDefines_),
+        ARCHIVE_FIELD_NAMED("techniques", techniques_), ARCHIVE_FIELD_NAMED("textures", textures_), ARCHIVE_FIELD_NAMED("parameters", parameters_),
+        ARCHIVE_FIELD_NAMED("cull", cullMode_), ARCHIVE_FIELD_NAMED("shadowcull", shadowCullMode_), ARCHIVE_FIELD_NAMED("fill", fillMode_),
+        ARCHIVE_FIELD_NAMED("constantbias", constantBias_), ARCHIVE_FIELD_NAMED("slopescaledbias", slopeScaledBias_),
+        ARCHIVE_FIELD_NAMED("alphatocoverage", alphaToCoverage_), ARCHIVE_FIELD_NAMED("lineantialias", lineAntiAlias_),
+        ARCHIVE_FIELD_NAMED("renderorder", renderOrder_), ARCHIVE_FIELD_NAMED("occlusion", occlusion_))
+};
+
+/// Archives Urho3D materials in two phases, like a Resource's BeginLoad/EndLoad.
+/// Phase one only touches the archive and the ResourceCache's background loader, so it can run on any thread. Phase two creates the material's state on the main thread.
+/// Shader parameter animations and UV transforms are not archived.
+class MaterialArchive
+{
+public:
+    /// Returns the description of the material, for output.
+    static MaterialDescription Describe(const Urho3D::Material& material);
+    /// Phase one, thread safe: reads the description saved under the name, resolves the texture types and queues the techniques and textures with ResourceCache::BackgroundLoadResource.
+    static bool BeginLoad(Archive& ar, const String& name, MaterialDescription& description, Urho3D::ResourceCache* cache);
+    /// Phase two, main thread only: applies the description to the material. Resources still loading in the background are waited for. Load into a new material, as units and parameters it doesn't mention are left as they are.
+    static void EndLoad(Urho3D::Material& material, const MaterialDescription& description);
+};
+
+}
@@ -0,0 +1,532 @@
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include "ArchiveUrhoTypes.h"
+#include "BinaryBackend.h"
+#include "SceneArchive.h"
+#include "SerializableBackend.h"
+
+inline namespace Archival {
+
+using namespace Urho3D;
+
+namespace {
+
+/// Decoded ID and file attributes of a node or component, keyed by the attribute name hash.
+struct SerializableData
+{
+    unsigned id_{};
+    Vector<Pair<StringHash, Variant>> attributes_;
+};
+
+/// Decoded component.
+struct ComponentData: SerializableData
+{
+    StringHash type_;
+};
+
+/// Decoded node with its components and children.
+struct NodeData: SerializableData
+{
+    Vector<ComponentData> components_;
+    Vector<NodeData> children_;
+};
+
+/// A subtree in a chunk, attached to the node that had the parent ID when saved. Shallow entries are saved without children, which follow in later entries.
+struct ChunkEntry
+{
+    Node* node_;
+    bool deep_;
+};
+
+/// A chunk being saved on a worker thread.
+struct SaveJob
+{
+    PODVector<ChunkEntry> entries_;
+    unsigned nodes_{};
+    VectorBuffer data_;
+    bool good_{};
+};
+
+/// A chunk being decoded on a worker thread.
+struct LoadJob
+{
+    PODVector<unsigned char> data_;
+    Vector<Pair<unsigned, NodeData>> entries_;
+    bool good_{};
+};
+
+bool IsFileAttribute(const AttributeInfo& info) { return (info.mode_ & AM_FILE) != 0; }
+
+/// Saves the file attributes as a series of {name, value}. The name is its hash for binary backends.
+bool SaveAttributes(Archive& ar, Serializable& serializable)
+{
+    const Vector<AttributeInfo>* attributes = serializable.GetAttributes();
+    PODVector<unsigned> saved;
+    if (attributes)
+        for (unsigned i = 0; i < attributes->Size(); ++i)
+            if (IsFileAttribute(attributes->At(i)))
+                saved.Push(i);
+
+    unsigned size = saved.Size();
+    if (!ar.SerializeSeriesSize("attributes", size))
+        return false;
+
+    const bool prefersBinary = ar.GetBackend().PrefersBinaryData();
+    bool good = true;
+    for (unsigned index : saved)
+    {
+        String name = attributes->At(index).name_;
+        Variant value = serializable.GetAttribute(index);
+        auto entry = ar.CreateSeriesEntry("attributes");
+        if (prefersBinary)
+        {
+            unsigned hash = StringHash(name).Value();
+            good &= static_cast<bool>(entry.Serialize("name", hash));
+        }
+        else
+            good &= static_cast<bool>(entry.Serialize("name", name));
+        good &= static_cast<bool>(entry.Serialize("value", value));
+    }
+    return good;
+}
+
+bool LoadAttributes(Archive& ar, SerializableData& data)
+{
+    unsigned size = 0;
+    if (!ar.SerializeSeriesSize("attributes", size))
+        return false;
+
+    const bool prefersBinary = ar.GetBackend().PrefersBinaryData();
+    data.attributes_.Resize(size);
+    for (auto& attribute : data.attributes_)
+    {
+        auto entry = ar.CreateSeriesEntry("attributes");
+        if (prefersBinary)
+        {
+            unsigned hash = 0;
+            if (!entry.Serialize("name", hash))
+                return false;
+            attribute.first_ = StringHash(hash);
+        }
+        else
+        {
+            String name;
+            if (!entry.Serialize("name", name))
+                return false;
+            attribute.first_ = StringHash(name);
+        }
+        if (!entry.Serialize("value", attribute.second_))
+            return false;
+    }
+    return true;
+}
+
+/// Saves a component's type (hash for binary backends, name otherwise), ID and attributes into the archive's current group.
+bool SaveComponentFields(Archive& ar, Component& component)
+{
+    unsigned id = component.GetID();
+    bool good;
+    if (ar.GetBackend().PrefersBinaryData())
+    {
+        unsigned type = component.GetType().Value();
+        good = ar.Serialize("type", type);
+    }
+    else
+    {
+        String type = component.GetTypeName();
+        good = ar.Serialize("type", type);
+    }
+    return good && ar.Serialize("id", id) && SaveAttributes(ar, component);
+}
+
+bool LoadComponentFields(Archive& ar, ComponentData& data)
+{
+    if (ar.GetBackend().PrefersBinaryData())
+    {
+        unsigned type = 0;
+        if (!ar.Serialize("type", type))
+            return false;
+        data.type_ = StringHash(type);
+    }
+    else
+    {
+        String type;
+        if (!ar.Serialize("type", type))
+            return false;
+        data.type_ = StringHash(type);
+    }
+    return ar.Serialize("id", data.id_) && LoadAttributes(ar, data);
+}
+
+/// Saves a node's ID, attributes and components into the archive's current group. Children are up to the caller.
+bool SaveNodeFields(Archive& ar, Node& node)
+{
+    unsigned id = node.GetID();
+    if (!ar.Serialize("id", id) || !SaveAttributes(ar, node))
+        return false;
+
+    PODVector<Component*> components;
+    for (Component* component : node.GetComponents())
+        if (!component->IsTemporary())
+            components.Push(component);
+    unsigned size = components.Size();
+    if (!ar.SerializeSeriesSize("components", size))
+        return false;
+
+    bool good = true;
+    for (Component* component : components)
+    {
+        auto entry = ar.CreateSeriesEntry("components");
+        good &= SaveComponentFields(entry, *component);
+    }
+    return good;
+}
+
+bool LoadNodeFields(Archive& ar, NodeData& data)
+{
+    unsigned size = 0;
+    if (!ar.Serialize("id", data.id_) || !LoadAttributes(ar, data) || !ar.SerializeSeriesSize("components", size))
+        return false;
+
+    data.components_.Resize(size);
+    for (ComponentData& component : data.components_)
+    {
+        auto entry = ar.CreateSeriesEntry("components");
+        if (!LoadComponentFields(entry, component))
+            return false;
+    }
+    return true;
+}
+
+/// Saves the node as a group, with its children if deep.
+bool SaveNode(Archive& ar, const String& name, Node& node, bool deep)
+{
+    auto group = ar.CreateGroup(name);
+    if (!SaveNodeFields(group, node))
+        return false;
+
+    PODVector<Node*> children;
+    if (deep)
+        for (Node* child : node.GetChildren())
+            if (!child->IsTemporary())
+                children.Push(child);
+    unsigned size = children.Size();
+    if (!group.SerializeSeriesSize("children", size))
+        return false;
+
+    bool good = true;
+    for (Node* child : children)
+    {
+        auto entry = group.CreateSeriesEntry("children");
+        good &= SaveNode(entry, entry.GetBackend().InlineName(), *child, true);
+    }
+    return good;
+}
+
+bool LoadNode(Archive& ar, const String& name, NodeData& data)
+{
+    auto group = ar.CreateGroup(name);
+    unsigned size = 0;
+    if (!LoadNodeFields(group, data) || !group.SerializeSeriesSize("children", size))
+        return false;
+
+    data.children_.Resize(size);
+    for (NodeData& child : data.children_)
+    {
+        auto entry = group.CreateSeriesEntry("children");
+        if (!LoadNode(entry, entry.GetBackend().InlineName(), child))
+            return false;
+    }
+    return true;
+}
+
+/// Splits the children of the node into chunks of about chunkNodes nodes. Subtrees larger than a chunk are split further, with the parent saved shallow ahead of its children.
+void Partition(Node& node, unsigned chunkNodes, Vector<SaveJob>& jobs)
+{
+    for (Node* child : node.GetChildren())
+    {
+        if (child->IsTemporary())
+            continue;
+        if (jobs.Empty() || jobs.Back().nodes_ >= chunkNodes)
+            jobs.Resize(jobs.Size() + 1);
+
+        const unsigned size = child->GetNumChildren(true) + 1;
+        const bool deep = size <= chunkNodes;
+        jobs.Back().entries_.Push({child, deep});
+        jobs.Back().nodes_ += deep ? size : 1;
+        if (!deep)
+            Partition(*child, chunkNodes, jobs);
+    }
+}
+
+void SaveChunk(const WorkItem* item, unsigned)
+{
+    auto* job = static_cast<SaveJob*>(item->aux_);
+    Archive ar = Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(job->data_));
+    unsigned size = job->entries_.Size();
+    job->good_ = ar.SerializeSeriesSize("nodes", size);
+    for (const ChunkEntry& entry : job->entries_)
+    {
+        auto nodeEntry = ar.CreateSeriesEntry("nodes");
+        unsigned parent = entry.node_->GetParent()->GetID();
+        job->good_ &= nodeEntry.Serialize("parent", parent) && SaveNode(nodeEntry, "node", *entry.node_, entry.deep_);
+    }
+}
+
+void LoadChunk(const WorkItem* item, unsigned)
+{
+    auto* job = static_cast<LoadJob*>(item->aux_);
+    MemoryBuffer source(job->data_);
+    Archive ar = Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(source));
+    unsigned size = 0;
+    job->good_ = ar.SerializeSeriesSize("nodes", size);
+    job->entries_.Resize(job->good_ ? size : 0);
+    for (auto& entry : job->entries_)
+    {
+        auto nodeEntry = ar.CreateSeriesEntry("nodes");
+        if (!nodeEntry.Serialize("parent", entry.first_) || !LoadNode(nodeEntry, "node", entry.second_))
+        {
+            job->good_ = false;
+            return;
+        }
+    }
+}
+
+/// Runs the work function over every job on the WorkQueue, with the calling thread helping, and waits for all of them. Runs them inline without a WorkQueue.
+template<class Job>
+void RunJobs(Context* context, Vector<Job>& jobs, void (*work)(const WorkItem*, unsigned))
+{
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    if (!queue || jobs.Size() < 2)
+    {
+        WorkItem item;
+        for (Job& job : jobs)
+        {
+            item.aux_ = &job;
+            work(&item, 0);
+        }
+        return;
+    }
+
+    for (Job& job : jobs)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = work;
+        item->aux_ = &job;
+        item->sendEvent_ = false;
+        queue->AddWorkItem(item);
+    }
+    queue->Complete(M_MAX_UNSIGNED);
+}
+
+/// Sets the decoded attributes on the serializable by name hash. Attributes it no longer has are skipped.
+void SetAttributes(Serializable& serializable, const SerializableData& data)
+{
+    auto index = Detail::SerializableBackend::GetAttributeIndex(serializable);
+    for (const auto& attribute : data.attributes_)
+    {
+        auto it = index->Find(attribute.first_);
+        if (it != index->End())
+            serializable.SetAttribute(it->second_, attribute.second_);
+    }
+}
+
+/// Queues every resource referenced by the decoded attributes, so that setting them waits on loads running in the background rather than loading each in turn.
+void PrefetchResources(const SerializableData& data, ArchivePrefetcher& prefetcher)
+{
+    for (const auto& attribute : data.attributes_)
+    {
+        const Variant& value = attribute.second_;
+        if (value.GetType() == VAR_RESOURCEREF)
+            prefetcher.Prefetch(value.GetResourceRef().type_, value.GetResourceRef().name_);
+        else if (value.GetType() == VAR_RESOURCEREFLIST)
+            for (const String& name : value.GetResourceRefList().names_)
+                prefetcher.Prefetch(value.GetResourceRefList().type_, name);
+    }
+}
+
+void PrefetchResources(const NodeData& data, ArchivePrefetcher& prefetcher)
+{
+    PrefetchResources(static_cast<const SerializableData&>(data), prefetcher);
+    for (const ComponentData& component : data.components_)
+        PrefetchResources(component, prefetcher);
+    for (const NodeData& child : data.children_)
+        PrefetchResources(child, prefetcher);
+}
+
+CreateMode ModeOf(unsigned id) { return id < FIRST_LOCAL_ID ? REPLICATED : LOCAL; }
+
+/// Creates the decoded components on the node and sets their attributes. Collects what was set up for ApplyAttributes.
+void CreateComponents(Node& node, const NodeData& data, PODVector<Serializable*>& created)
+{
+    SetAttributes(node, data);
+    created.Push(&node);
+    for (const ComponentData& componentData : data.components_)
+    {
+        Component* component = node.CreateComponent(componentData.type_, ModeOf(componentData.id_), componentData.id_);
+        if (!component)
+        {
+            URHO3D_LOGWARNING("SceneArchive could not create component of type " + componentData.type_.ToString());
+            continue;
+        }
+        SetAttributes(*component, componentData);
+        created.Push(component);
+    }
+}
+
+/// Creates the decoded node as a child of the parent, then its descendants. Records every node by its saved ID for the chunks that attach to it.
+void CreateNode(Node& parent, const NodeData& data, HashMap<unsigned, Node*>& nodes, PODVector<Serializable*>& created)
+{
+    Node* node = parent.CreateChild(data.id_, ModeOf(data.id_));
+    nodes[data.id_] = node;
+    CreateComponents(*node, data, created);
+    for (const NodeData& child : data.children_)
+        CreateNode(*node, child, nodes, created);
+}
+
+}
+
+bool SceneArchive::Save(Archive &ar, const String &name, Node &root, unsigned chunkNodes)
+{
+    if (!ar.GetBackend().PrefersBinaryData())
+        return SaveNode(ar, name, root, true);
+
+    auto group = ar.CreateGroup(name);
+    if (!SaveNodeFields(group, root))
+        return false;
+
+    Vector<SaveJob> jobs;
+    Partition(root, Max(chunkNodes, 1u), jobs);
+    RunJobs(root.GetContext(), jobs, SaveChunk);
+
+    // The index lets a loader see the node counts and sizes before reading the chunks.
+    unsigned size = jobs.Size();
+    if (!group.SerializeSeriesSize("index", size))
+        return false;
+    bool good = true;
+    for (SaveJob& job : jobs)
+    {
+        auto entry = group.CreateSeriesEntry("index");
+        unsigned bytes = job.data_.GetSize();
+        good &= job.good_ && entry.Serialize("nodes", job.nodes_) && entry.Serialize("bytes", bytes);
+    }
+    if (!good || !group.SerializeSeriesSize("chunks", size))
+        return false;
+    for (SaveJob& job : jobs)
+        good &= static_cast<bool>(group.CreateSeriesEntry("chunks").SerializeInline(const_cast<PODVector<unsigned char>&>(job.data_.GetBuffer())));
+    return good;
+}
+
+bool SceneArchive::Load(Archive &ar, const String &name, Node &root)
+{
+    NodeData rootData;
+    Vector<LoadJob> jobs;
+    if (!ar.GetBackend().PrefersBinaryData())
+    {
+        if (!LoadNode(ar, name, rootData))
+            return false;
+    }
+    else
+    {
+        auto group = ar.CreateGroup(name);
+        unsigned size = 0;
+        if (!LoadNodeFields(group, rootData) || !group.SerializeSeriesSize("index", size))
+            return false;
+
+        jobs.Resize(size);
+        for (LoadJob& job : jobs)
+        {
+            auto entry = group.CreateSeriesEntry("index");
+            unsigned nodes = 0, bytes = 0;
+            if (!entry.Serialize("nodes", nodes) || !entry.Serialize("bytes", bytes))
+                return false;
+            job.data_.Reserve(bytes);
+        }
+        if (!group.SerializeSeriesSize("chunks", size) || size != jobs.Size())
+            return false;
+        for (LoadJob& job : jobs)
+            if (!group.CreateSeriesEntry("chunks").SerializeInline(job.data_))
+                return false;
+
+        RunJobs(root.GetContext(), jobs, LoadChunk);
+        for (const LoadJob& job : jobs)
+            if (!job.good_)
+                return false;
+    }
+
+    // All of the tree is decoded before anything is created, so every referenced resource can be loading before the first attribute is set.
+    if (auto* cache = root.GetSubsystem<ResourceCache>())
+    {
+        SharedPtr<ArchivePrefetcher> prefetcher(ar.GetPrefetcher() ? ar.GetPrefetcher() : new ArchivePrefetcher(cache));
+        PrefetchResources(rootData, *prefetcher);
+        for (const LoadJob& job : jobs)
+            for (const auto& entry : job.entries_)
+                PrefetchResources(entry.second_, *prefetcher);
+    }
+
+    // Everything is decoded, so only node and component creation is left for this thread.
+    HashMap<unsigned, Node*> nodes;
+    PODVector<Serializable*> created;
+    nodes[rootData.id_] = &root;
+    CreateComponents(root, rootData, created);
+    for (const NodeData& child : rootData.children_)
+        CreateNode(root, child, nodes, created);
+
+    for (const LoadJob& job : jobs)
+    {
+        for (const auto& entry : job.entries_)
+        {
+            auto parent = nodes.Find(entry.first_);
+            if (parent == nodes.End())
+            {
+                URHO3D_LOGERROR("SceneArchive chunk refers to unknown parent node " + String(entry.first_));
+                return false;
+            }
+            CreateNode(*parent->second_, entry.second_, nodes, created);
+        }
+    }
+
+    // Apply once everything exists, so attributes referring to other nodes and components resolve.
+    for (Serializable* serializable : created)
+        serializable->ApplyAttributes();
+    return true;
+}
+
+}
+
+namespace Urho3D
+{
+
+ArchiveResult<Archive, Node> ArchiveValue(Archive &archive, const String &name, Node &self)
+{
+    bool good = archive.IsInput() ? SceneArchive::Load(archive, name, self) : SceneArchive::Save(archive, name, self);
+    return {archive, good, self};
+}
+
+ArchiveResult<Archive, Scene> ArchiveValue(Archive &archive, const String &name, Scene &self)
+{
+    if (archive.IsInput())
+        self.Clear();
+    bool good = archive.IsInput() ? SceneArchive::Load(archive, name, self) : SceneArchive::Save(archive, name, self);
+    return {archive, good, self};
+}
+
+ArchiveResult<Archive, Component> ArchiveValue(Archive &archive, const String &name, Component &self)
+{
+    auto group = archive.CreateGroup(name);
+    if (!archive.IsInput())
+        return {archive, SaveComponentFields(group, self), self};
+
+    ComponentData data;
+    if (!LoadComponentFields(group, data) || data.type_ != self.GetType())
+        return {archive, false, self};
+    SetAttributes(self, data);
+    self.ApplyAttributes();
+    return {archive, true, self};
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Urho3D/Scene/Scene.h>
+
+#include "Archive.h"
+
+inline namespace Archival {
+
+/// Archives Urho3D node hierarchies: every node's ID, file attributes (as Variants) and components, and its children.
+/// Binary backends partition the tree into chunks of about chunkNodes nodes that are encoded on WorkQueue threads into their own positional binary archives, then stored as byte buffers after a chunk index.
+/// Loading decodes the chunks in parallel into plain data and only creates the nodes and components on the calling (main) thread. Text backends store the tree inline and load it on the calling thread.
+/// IDs are kept, so load into an empty scene. The tree must not be modified while it is being saved, as worker threads read its attributes.
+class SceneArchive
+{
+public:
+    /// Default number of nodes per chunk.
+    static constexpr unsigned DEFAULT_CHUNK_NODES{4096};
+
+    /// Saves the node, its components and its (non-temporary) descendants under the name.
+    static bool Save(Archive& ar, const String& name, Urho3D::Node& root, unsigned chunkNodes = DEFAULT_CHUNK_NODES);
+    /// Loads the node saved under the name into root: applies its attributes, creates its components and creates its descendants as children.
+    static bool Load(Archive& ar, const String& name, Urho3D::Node& root);
+};
+
+}
+
+namespace Urho3D
+{
+
+using Archival::ArchiveResult;
+/// Archives the node and its descendants with SceneArchive.
+ArchiveResult<Archive, Node> ArchiveValue(Archive& archive, const String& name, Node& self);
+/// Archives the scene with SceneArchive. Input clears the scene first.
+ArchiveResult<Archive, Scene> ArchiveValue(Archive& archive, const String& name, Scene& self);
+/// Archives the component's ID and file attributes. Input applies them to the existing component.
+ArchiveResult<Archive, Component> ArchiveValue(Archive& archive, const String& name, Component& self);
+}
@@ -0,0 +1,151 @@
+#include "SerializableBackend.h"
+
+inline namespace Archival {
+namespace Detail {
+
+SerializableBackend::SerializableBackend(Serializable &serializable)
+    : serializable_(serializable), attributes_(serializable.GetAttributes()), index_(GetAttributeIndex(serializable))
+{
+}
+
+SerializableBackend::~SerializableBackend()
+{
+    if (dirty_)
+        serializable_.ApplyAttributes();
+}
+
+Archive SerializableBackend::MakeArchive(Serializable &serializable, bool isInput)
+{
+    return Archive(isInput, new SerializableBackend(serializable));
+}
+
+std::shared_ptr<const SerializableBackend::AttributeIndex> SerializableBackend::GetAttributeIndex(const Serializable &serializable)
+{
+    const Vector<AttributeInfo>* attributes = serializable.GetAttributes();
+    const unsigned count = attributes ? attributes->Size() : 0;
+
+    std::lock_guard<std::mutex> lock(IndexMutex());
+    CachedIndex& cached = IndexCache()[serializable.GetType()];
+    if (!cached.index_ || cached.attributeCount_ != count)
+    {
+        auto index = std::make_shared<AttributeIndex>();
+        for (unsigned i = 0; i < count; ++i)
+            index->Insert(MakePair(StringHash(attributes->At(i).name_), i));
+        cached.index_ = index;
+        cached.attributeCount_ = count;
+    }
+    return cached.index_;
+}
+
+bool SerializableBackend::GetEntryNames(StringVector &names)
+{
+    if (!attributes_)
+        return true;
+    for (const AttributeInfo& attribute : *attributes_)
+        names.Push(attribute.name_);
+    return true;
+}
+
+unsigned SerializableBackend::FindEntry(const EntryAlternative *alternatives, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const unsigned index = Find(*alternatives[i].name);
+        if (index == INVALID_ATTRIBUTE)
+            continue;
+
+        const VariantType type = attributes_->At(index).type_;
+        switch (alternatives[i].form)
+        {
+        case ANY_FORM:
+            return i;
+        case NUMBER_FORM:
+            if (type == VAR_BOOL || type == VAR_INT || type == VAR_INT64 || type == VAR_FLOAT || type == VAR_DOUBLE)
+                return i;
+            break;
+        case STRING_FORM:
+            if (type == VAR_STRING)
+                return i;
+            break;
+        case BUFFER_FORM:
+            if (type == VAR_BUFFER)
+                return i;
+            break;
+        case GROUP_FORM:
+        case SERIES_FORM:
+            break;
+        }
+    }
+    return MISSING_ENTRY;
+}
+
+bool SerializableBackend::DescribeEntry(const String &name, EntryForm &form, RecordFieldType &type)
+{
+    const unsigned index = Find(name);
+    if (index == INVALID_ATTRIBUTE)
+        return false;
+
+    // Only the types a Transcoder can pump are described.
+    form = NUMBER_FORM;
+    switch (attributes_->At(index).type_)
+    {
+    case VAR_NONE: form = ANY_FORM; type = RECORD_NONE; return true;
+    case VAR_BOOL: type = RECORD_BOOL; return true;
+    case VAR_INT: type = RECORD_SINT; return true;
+    case VAR_INT64: type = RECORD_SLONGLONG; return true;
+    case VAR_FLOAT: type = RECORD_FLOAT; return true;
+    case VAR_DOUBLE: type = RECORD_DOUBLE; return true;
+    case VAR_STRING: form = STRING_FORM; type = RECORD_STRING; return true;
+    case VAR_BUFFER: form = BUFFER_FORM; type = RECORD_NONE; return true;
+    default: return false;
+    }
+}
+
+bool SerializableBackend::GetRecord(RecordField *fields, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const unsigned index = Find(StringHash(fields[i].hash));
+        bool good = VisitRecordField(fields[i], [this, index](const String&, auto& val)
+        {
+            return GetField(index, val);
+        });
+        if (!good)
+            return false;
+    }
+    return true;
+}
+
+bool SerializableBackend::SetRecord(const RecordField *fields, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const unsigned index = Find(StringHash(fields[i].hash));
+        bool good = VisitRecordField(fields[i], [this, index](const String&, auto& val)
+        {
+            return SetField(index, val);
+        });
+        if (!good)
+            return false;
+    }
+    return true;
+}
+
+bool SerializableBackend::Get(const String &name, const std::nullptr_t &)
+{
+    const unsigned index = Find(name);
+    return index != INVALID_ATTRIBUTE && serializable_.GetAttribute(index).IsEmpty();
+}
+
+bool SerializableBackend::SetVariant(unsigned index, const Variant &value)
+{
+    if (index == INVALID_ATTRIBUTE || attributes_->At(index).type_ != value.GetType())
+        return false;
+    if (!serializable_.SetAttribute(index, value))
+        return false;
+    dirty_ = true;
+    return true;
+}
+
+}
+}
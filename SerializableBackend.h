@@ -0,0 +1,201 @@
+#pragma once
+
+#include <Urho3D/Scene/Serializable.h>
+
+#include <memory>
+#include <mutex>
+
+#include "Archive.h"
+
+inline namespace Archival {
+namespace Detail {
+
+using namespace Urho3D;
+
+/// Archival Backend that reads and writes the attributes of an Urho3D Serializable by name, so any ArchiveValue code can drive GetAttribute/SetAttribute (editor property binding, replicating existing components).
+/// Attributes are flat: groups and series are not supported, except that attributes holding an extended type (Vector3, Color, ...) are archived through it directly,
+/// and that the inline group is the Serializable itself, so SerializeInline archives the fields of an ARCHIVE_FIELDS type straight into its attributes.
+/// Numbers are converted to and from the attribute's own type. Attribute names are resolved through an index built once per type and shared by every backend, so no lookup scans GetAttributes().
+class SerializableBackend: public Backend
+{
+public:
+    /// Construct for the Serializable, which must outlive the backend. Input reads its attributes, output sets them and calls ApplyAttributes when done.
+    explicit SerializableBackend(Serializable& serializable);
+    /// Destruct. Applies the attributes if any were set.
+    ~SerializableBackend() override;
+
+    /// Returns the name of the backend
+    const String& GetBackendName() override { static const String name("SERIALIZABLE"); return name; }
+
+    /// Utility method to create an Archive with a SerializableBackend.
+    static Archive MakeArchive(Serializable& serializable, bool isInput);
+
+    /// Attribute indices by the StringHash of the attribute name.
+    using AttributeIndex = HashMap<StringHash, unsigned>;
+    /// Returns the attribute index of the Serializable's type, building it on first use. Rebuilt if attributes were registered since. Thread safe.
+    static std::shared_ptr<const AttributeIndex> GetAttributeIndex(const Serializable& serializable);
+
+    Backend* CreateGroup(const String &name, bool) override { return IsInline(name) ? new SerializableBackend(serializable_) : nullptr; }
+    Backend* CreateSeriesEntry(const String &, bool) override { return nullptr; }
+    bool GetSeriesSize(const String &, unsigned &) override { return false; }
+    bool SetSeriesSize(const String &, const unsigned &) override { return false; }
+    /// Lists the names of every attribute.
+    bool GetEntryNames(StringVector &names) override;
+    bool SetEntryNames(const StringVector &) override { return true; }
+    unsigned char InlineSeriesVerbosity() const override { return 0; }
+    bool SupportsExtendedTypes() const override { return true; }
+    unsigned FindEntry(const EntryAlternative* alternatives, unsigned count) override;
+    bool DescribeEntry(const String &name, EntryForm &form, RecordFieldType &type) override;
+    bool SupportsRecords() const override { return true; }
+    /// Looks fields up by their precomputed name hash.
+    bool GetRecord(RecordField* fields, unsigned count) override;
+    bool SetRecord(const RecordField* fields, unsigned count) override;
+
+    /// Null is an empty attribute.
+    bool Get(const String &name, const std::nullptr_t &) override;
+    bool Get(const String &name, bool &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, unsigned char &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, signed char &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, unsigned short &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, signed short &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, unsigned int &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, signed int &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, unsigned long long &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, signed long long &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, float &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, double &val) override { return GetNumber(Find(name), val); }
+    bool Get(const String &name, String &val) override { return GetExact(Find(name), VAR_STRING, val); }
+    bool Get(const String &name, PODVector<unsigned char> &val) override { return GetExact(Find(name), VAR_BUFFER, val); }
+
+#ifdef EXTENDED_ARCHIVE_TYPES
+    bool Get(const String &name, Urho3D::IntVector2 &val) override { return GetExact(Find(name), VAR_INTVECTOR2, val); }
+    bool Get(const String &name, Urho3D::IntVector3 &val) override { return GetExact(Find(name), VAR_INTVECTOR3, val); }
+    bool Get(const String &name, Urho3D::Vector2 &val) override { return GetExact(Find(name), VAR_VECTOR2, val); }
+    bool Get(const String &name, Urho3D::Vector3 &val) override { return GetExact(Find(name), VAR_VECTOR3, val); }
+    bool Get(const String &name, Urho3D::Vector4 &val) override { return GetExact(Find(name), VAR_VECTOR4, val); }
+    bool Get(const String &name, Urho3D::Quaternion &val) override { return GetExact(Find(name), VAR_QUATERNION, val); }
+    bool Get(const String &name, Urho3D::Color &val) override { return GetExact(Find(name), VAR_COLOR, val); }
+    bool Get(const String &name, Urho3D::Matrix3 &val) override { return GetExact(Find(name), VAR_MATRIX3, val); }
+    bool Get(const String &name, Urho3D::Matrix3x4 &val) override { return GetExact(Find(name), VAR_MATRIX3X4, val); }
+    bool Get(const String &name, Urho3D::Matrix4 &val) override { return GetExact(Find(name), VAR_MATRIX4, val); }
+#endif
+
+    bool Set(const String &name, const std::nullptr_t &) override { return SetVariant(Find(name), Variant::EMPTY); }
+    bool Set(const String &name, const bool &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const unsigned char &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const signed char &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const unsigned short &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const signed short &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const unsigned int &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const signed int &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const unsigned long long &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const signed long long &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const float &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const double &val) override { return SetNumber(Find(name), val); }
+    bool Set(const String &name, const String &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const PODVector<unsigned char> &val) override { return SetVariant(Find(name), val); }
+
+#ifdef EXTENDED_ARCHIVE_TYPES
+    bool Set(const String &name, const Urho3D::IntVector2 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::IntVector3 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Vector2 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Vector3 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Vector4 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Quaternion &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Color &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Matrix3 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Matrix3x4 &val) override { return SetVariant(Find(name), val); }
+    bool Set(const String &name, const Urho3D::Matrix4 &val) override { return SetVariant(Find(name), val); }
+#endif
+
+private:
+    /// Returned by Find for names that aren't attributes.
+    static constexpr unsigned INVALID_ATTRIBUTE{0xFFFFFFFF};
+
+    /// Returns the index of the attribute with the name hash, or INVALID_ATTRIBUTE.
+    unsigned Find(StringHash hash) const
+    {
+        auto it = index_->Find(hash);
+        return it != index_->End() ? it->second_ : INVALID_ATTRIBUTE;
+    }
+    /// Returns the index of the attribute with the name, or INVALID_ATTRIBUTE.
+    unsigned Find(const String& name) const { return IsInline(name) ? INVALID_ATTRIBUTE : Find(StringHash(name)); }
+
+    /// Gets a numeric attribute of any numeric type.
+    template<class T>
+    bool GetNumber(unsigned index, T& val)
+    {
+        if (index == INVALID_ATTRIBUTE)
+            return false;
+        const Variant value = serializable_.GetAttribute(index);
+        switch (value.GetType())
+        {
+        case VAR_BOOL: val = static_cast<T>(value.GetBool()); return true;
+        case VAR_INT: val = static_cast<T>(value.GetInt()); return true;
+        case VAR_INT64: val = static_cast<T>(value.GetInt64()); return true;
+        case VAR_FLOAT: val = static_cast<T>(value.GetFloat()); return true;
+        case VAR_DOUBLE: val = static_cast<T>(value.GetDouble()); return true;
+        default: return false;
+        }
+    }
+
+    /// Sets a numeric attribute, converting to its own numeric type.
+    template<class T>
+    bool SetNumber(unsigned index, T val)
+    {
+        if (index == INVALID_ATTRIBUTE)
+            return false;
+        switch (attributes_->At(index).type_)
+        {
+        case VAR_BOOL: return SetVariant(index, val != 0);
+        case VAR_INT: return SetVariant(index, static_cast<int>(val));
+        case VAR_INT64: return SetVariant(index, static_cast<long long>(val));
+        case VAR_FLOAT: return SetVariant(index, static_cast<float>(val));
+        case VAR_DOUBLE: return SetVariant(index, static_cast<double>(val));
+        default: return false;
+        }
+    }
+
+    /// Gets an attribute that must be of the type.
+    template<class T>
+    bool GetExact(unsigned index, VariantType type, T& val)
+    {
+        if (index == INVALID_ATTRIBUTE || attributes_->At(index).type_ != type)
+            return false;
+        val = serializable_.GetAttribute(index).Get<T>();
+        return true;
+    }
+
+    /// Gets a record field by attribute index.
+    template<class T>
+    bool GetField(unsigned index, T& val) { return GetNumber(index, val); }
+    bool GetField(unsigned index, String& val) { return GetExact(index, VAR_STRING, val); }
+    /// Sets a record field by attribute index.
+    template<class T>
+    bool SetField(unsigned index, const T& val) { return SetNumber(index, val); }
+    bool SetField(unsigned index, const String& val) { return SetVariant(index, val); }
+
+    /// Sets the attribute if the value has its type.
+    bool SetVariant(unsigned index, const Variant& value);
+
+    /// The Serializable whose attributes are archived.
+    Serializable& serializable_;
+    /// Its attributes.
+    const Vector<AttributeInfo>* attributes_;
+    /// The shared attribute index of its type.
+    std::shared_ptr<const AttributeIndex> index_;
+    /// True once an attribute has been set.
+    bool dirty_{};
+
+    /// Attribute indices of every type seen, and the number of attributes they were built from.
+    struct CachedIndex
+    {
+        std::shared_ptr<const AttributeIndex> index_;
+        unsigned attributeCount_;
+    };
+    static HashMap<StringHash, CachedIndex>& IndexCache() { static HashMap<StringHash, CachedIndex> cache; return cache; }
+    static std::mutex& IndexMutex() { static std::mutex mutex; return mutex; }
+};
+
+}
+}
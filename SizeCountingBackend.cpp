@@ -0,0 +1,161 @@
+#include "Base64.h"
+#include "SizeCountingBackend.h"
+
+#include <cstdio>
+
+inline namespace Archival {
+namespace Detail {
+
+SizeCountingBackend::SizeCountingBackend(Format format, SizeTally &tally, bool lengthPrefixedGroups)
+    : format_(format), tally_(tally), lengthPrefixedGroups_(lengthPrefixedGroups), groupIndex_(INVALID_GROUP), groupStart_(tally.bytes)
+{
+}
+
+SizeCountingBackend::SizeCountingBackend(const SizeCountingBackend &parent, unsigned groupIndex)
+    : format_(parent.format_), tally_(parent.tally_), lengthPrefixedGroups_(parent.lengthPrefixedGroups_), groupIndex_(groupIndex), groupStart_(parent.tally_.bytes)
+{
+}
+
+SizeCountingBackend::~SizeCountingBackend()
+{
+    if (groupIndex_ == INVALID_GROUP)
+        return;
+
+    // Every binary group starts with its bit block.
+    if (format_ == FORMAT_BINARY)
+    {
+        tally_.bytes += VLESize(packedBits_) + ((packedBits_ + 7) >> 3);
+        tally_.groupBitCounts[groupIndex_] = packedBits_;
+        tally_.groupBitOffsets[groupIndex_] = tally_.groupBits.Size();
+        tally_.groupBits.Push(bits_);
+    }
+    unsigned size = static_cast<unsigned>(tally_.bytes - groupStart_);
+    tally_.groupSizes[groupIndex_] = size;
+    if (format_ == FORMAT_BINARY && lengthPrefixedGroups_)
+        tally_.bytes += VLESize(size);
+}
+
+Archive SizeCountingBackend::MakeArchive(Format format, SizeTally &tally, bool lengthPrefixedGroups)
+{
+    return Archive(false, new SizeCountingBackend(format, tally, lengthPrefixedGroups));
+}
+
+Backend *SizeCountingBackend::CreateGroup(const String &name, bool isInput)
+{
+    if (isInput)
+        return nullptr;
+
+    // The group's braces are counted with its first key.
+    CountKey(name);
+    tally_.groupSizes.Push(0);
+    tally_.groupBitCounts.Push(0);
+    tally_.groupBitOffsets.Push(0);
+    return new SizeCountingBackend(*this, tally_.groupSizes.Size() - 1);
+}
+
+Backend *SizeCountingBackend::CreateSeriesEntry(const String &name, bool isInput)
+{
+    if (isInput)
+        return nullptr;
+
+    if (format_ == FORMAT_JSON)
+    {
+        auto entry = entries_.Find(name);
+        if (entry == entries_.End())
+        {
+            entries_[name] = 1;
+            CountKey(name);
+            tally_.bytes += 2;
+        }
+        else if (entry->second_++ > 0)
+            tally_.bytes += 1;
+    }
+    return new SizeCountingBackend(*this, INVALID_GROUP);
+}
+
+bool SizeCountingBackend::SetSeriesSize(const String &name, const unsigned &size)
+{
+    tally_.seriesSizes.Push(size);
+    if (format_ == FORMAT_BINARY)
+        tally_.bytes += VLESize(size);
+    return true;
+}
+
+bool SizeCountingBackend::SetEntryNames(const StringVector &names)
+{
+    if (format_ != FORMAT_BINARY)
+        return true;
+
+    tally_.bytes += VLESize(names.Size());
+    for (const String& name : names)
+    {
+        tally_.bytes += VLESize(name.Length()) + name.Length();
+        tally_.stringBytes += name.Length();
+    }
+    return true;
+}
+
+bool SizeCountingBackend::WriteConditional(bool condition, bool isInput)
+{
+    if (!isInput)
+        CountBit(condition);
+    return Backend::WriteConditional(condition, isInput);
+}
+
+bool SizeCountingBackend::WritePresence(const String &name, bool present, bool isInput)
+{
+    if (isInput)
+        return false;
+    CountBit(present);
+    return present;
+}
+
+bool SizeCountingBackend::Set(const String &name, const bool &val)
+{
+    if (format_ != FORMAT_BINARY)
+        return CountValue(name, val, val ? 4 : 5);
+    ++tally_.values;
+    CountBit(val);
+    return true;
+}
+
+bool SizeCountingBackend::Set(const String &name, const String &val)
+{
+    ++tally_.values;
+    tally_.stringBytes += val.Length();
+    if (format_ == FORMAT_BINARY)
+        tally_.bytes += VLESize(val.Length()) + val.Length();
+    else
+        CountText(name, val.Length() + 2);
+    return true;
+}
+
+bool SizeCountingBackend::Set(const String &name, const PODVector<unsigned char> &val)
+{
+    ++tally_.values;
+    if (format_ == FORMAT_BINARY)
+        tally_.bytes += sizeof(unsigned) + val.Size();
+    else
+        CountText(name, Base64::EncodedLength(val.Size()) + 2);
+    return true;
+}
+
+void SizeCountingBackend::CountKey(const String &name)
+{
+    if (format_ != FORMAT_JSON || IsInline(name))
+        return;
+
+    // Opening brace for the first key, a comma for the rest, then "name":
+    tally_.bytes += (empty_ ? 2 : 1) + name.Length() + 3;
+    empty_ = false;
+}
+
+unsigned SizeCountingBackend::FloatDigits(double value)
+{
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return length > 0 ? static_cast<unsigned>(length) : 1;
+}
+
+}
+}
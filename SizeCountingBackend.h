@@ -0,0 +1,219 @@
+#pragma once
+
+#include "Archive.h"
+
+inline namespace Archival {
+namespace Detail {
+
+using namespace Urho3D;
+
+/// Result of a SizeCountingBackend pass.
+struct SizeTally
+{
+    /// Total bytes the target format would produce.
+    unsigned long long bytes{};
+    /// Number of scalar values written.
+    unsigned values{};
+    /// Total bytes of string contents, excluding length prefixes and quotes.
+    unsigned long long stringBytes{};
+    /// Sizes passed to SetSeriesSize, in traversal order.
+    PODVector<unsigned> seriesSizes;
+    /// Byte size of the contents of every group, in the order the groups were created. Lets BinaryBackend write length-prefixed groups without backpatching.
+    PODVector<unsigned> groupSizes;
+    /// Number of bits in the bit block of every group, in the order the groups were created. FORMAT_BINARY only.
+    PODVector<unsigned> groupBitCounts;
+    /// Offset of the bit block of every group into groupBits, in the order the groups were created. FORMAT_BINARY only.
+    PODVector<unsigned> groupBitOffsets;
+    /// The bit blocks of every group, each starting on a byte boundary. Lets BinaryBackend write a group's bits ahead of its contents without buffering them.
+    PODVector<unsigned char> groupBits;
+};
+
+/// Archival Backend that writes nothing but tallies how many bytes a target format would produce for the same output traversal.
+/// Run the same ArchiveValue through it first, then allocate the real output once (see BinaryBackend::WriteSized).
+/// Exact for FORMAT_BINARY. An estimate for FORMAT_JSON (compact output, no escaping or indentation).
+class SizeCountingBackend: public Backend
+{
+public:
+    /// The format to count bytes for.
+    enum Format
+    {
+        /// The BinaryBackend layout.
+        FORMAT_BINARY,
+        /// Compact JSON text as produced from a JSONBackend.
+        FORMAT_JSON,
+    };
+
+    /// Construct to count into the provided tally, which must outlive the backend. Set lengthPrefixedGroups to count the group prefixes BinaryBackend writes when given the tally.
+    SizeCountingBackend(Format format, SizeTally& tally, bool lengthPrefixedGroups = false);
+
+    /// Destruct. Records the size of the group if this backend was created for one.
+    ~SizeCountingBackend() override;
+
+    /// Returns the name of the backend
+    const String& GetBackendName() override { static const String name("SIZE"); return name; }
+
+    /// Utility method to create an output Archive with a SizeCountingBackend.
+    static Archive MakeArchive(Format format, SizeTally& tally, bool lengthPrefixedGroups = false);
+
+    /// Utility method that runs the output traversal of the value and returns the tally.
+    template<class T>
+    static SizeTally Measure(Format format, const String& name, T& value, bool lengthPrefixedGroups = false)
+    {
+        SizeTally tally;
+        MakeArchive(format, tally, lengthPrefixedGroups).Serialize(name, value);
+        return tally;
+    }
+
+    /// Returns the number of bytes Serializer::WriteVLE uses for the value.
+    static unsigned VLESize(unsigned value)
+    {
+        return value < 0x80 ? 1 : value < 0x4000 ? 2 : value < 0x200000 ? 3 : 4;
+    }
+
+    Backend* CreateGroup(const String &name, bool isInput) override;
+    Backend* CreateSeriesEntry(const String &name, bool isInput) override;
+    bool GetSeriesSize(const String &, unsigned &) override { return false; }
+    bool SetSeriesSize(const String &name, const unsigned &size) override;
+    bool GetEntryNames(StringVector &) override { return false; }
+    bool SetEntryNames(const StringVector &names) override;
+    unsigned char InlineSeriesVerbosity() const override { return format_ == FORMAT_BINARY ? 0 : 10; }
+    bool PrefersBinaryData() const override { return format_ == FORMAT_BINARY; }
+    bool SupportsExtendedTypes() const override { return format_ == FORMAT_BINARY; }
+    unsigned FindEntry(const EntryAlternative*, unsigned) override { return MISSING_ENTRY; }
+    bool WriteConditional(bool condition, bool isInput) override;
+    bool WritePresence(const String &name, bool present, bool isInput) override;
+
+    /// Output only.
+    bool Get(const String &, const std::nullptr_t &) override { return false; }
+    bool Get(const String &, bool &) override { return false; }
+    bool Get(const String &, unsigned char &) override { return false; }
+    bool Get(const String &, signed char &) override { return false; }
+    bool Get(const String &, unsigned short &) override { return false; }
+    bool Get(const String &, signed short &) override { return false; }
+    bool Get(const String &, unsigned int &) override { return false; }
+    bool Get(const String &, signed int &) override { return false; }
+    bool Get(const String &, unsigned long long &) override { return false; }
+    bool Get(const String &, signed long long &) override { return false; }
+    bool Get(const String &, float &) override { return false; }
+    bool Get(const String &, double &) override { return false; }
+    bool Get(const String &, String &) override { return false; }
+
+    bool Set(const String &name, const std::nullptr_t &) override { return CountText(name, 4); }
+    bool Set(const String &name, const bool &val) override;
+    bool Set(const String &name, const unsigned char &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const signed char &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const unsigned short &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const signed short &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const unsigned int &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const signed int &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const unsigned long long &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const signed long long &val) override { return CountValue(name, val, Digits(val)); }
+    bool Set(const String &name, const float &val) override { return CountValue(name, val, FloatDigits(val)); }
+    bool Set(const String &name, const double &val) override { return CountValue(name, val, FloatDigits(val)); }
+    bool Set(const String &name, const String &val) override;
+    bool Set(const String &name, const PODVector<unsigned char> &val) override;
+
+#ifdef EXTENDED_ARCHIVE_TYPES
+    /// The binary format stores extended types natively; JSON falls back to their components.
+    bool Set(const String &name, const Urho3D::IntVector2 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::IntVector3 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Vector2 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Vector3 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Vector4 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Quaternion &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Color &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Matrix3 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Matrix3x4 &val) override { return CountExtended(name, val); }
+    bool Set(const String &name, const Urho3D::Matrix4 &val) override { return CountExtended(name, val); }
+#endif
+
+private:
+    /// Internal constructor for groups and series entries.
+    SizeCountingBackend(const SizeCountingBackend& parent, unsigned groupIndex);
+
+    /// Counts the key (and separator) a named JSON value adds. Nothing for binary.
+    void CountKey(const String& name);
+
+    /// Counts a scalar: sizeof(T) for binary, textLength characters for JSON.
+    template<class T>
+    bool CountValue(const String& name, const T&, unsigned textLength)
+    {
+        ++tally_.values;
+        if (format_ == FORMAT_BINARY)
+            tally_.bytes += sizeof(T);
+        else
+            return CountText(name, textLength);
+        return true;
+    }
+
+    /// Counts a bit the binary format packs into the group's bit block, or a byte outside of groups.
+    void CountBit(bool bit)
+    {
+        if (format_ != FORMAT_BINARY)
+            return;
+        if (groupIndex_ == INVALID_GROUP)
+        {
+            tally_.bytes += 1;
+            return;
+        }
+        if ((packedBits_ & 7) == 0)
+            bits_.Push(0);
+        if (bit)
+            bits_.Back() |= 1 << (packedBits_ & 7);
+        ++packedBits_;
+    }
+
+    /// Counts a JSON value of the specified text length.
+    bool CountText(const String& name, unsigned textLength)
+    {
+        if (format_ == FORMAT_JSON)
+        {
+            CountKey(name);
+            tally_.bytes += textLength;
+        }
+        return true;
+    }
+
+    /// Counts an extended type for binary. Fails for JSON so the components get counted instead.
+    template<class T>
+    bool CountExtended(const String&, const T&)
+    {
+        if (format_ != FORMAT_BINARY)
+            return false;
+        ++tally_.values;
+        tally_.bytes += sizeof(T);
+        return true;
+    }
+
+    /// Number of characters in the decimal representation.
+    static unsigned Digits(int value) { return Digits(static_cast<long long>(value)); }
+    static unsigned Digits(unsigned value) { return Digits(static_cast<unsigned long long>(value)); }
+    static unsigned Digits(long long value) { return value < 0 ? 1 + Digits(0ull - static_cast<unsigned long long>(value)) : Digits(static_cast<unsigned long long>(value)); }
+    static unsigned Digits(unsigned long long value) { unsigned d = 1; while (value >= 10) { value /= 10; ++d; } return d; }
+    /// Number of characters in the JSON representation of the floating point value.
+    static unsigned FloatDigits(double value);
+
+    /// The format being counted.
+    Format format_;
+    /// The tally shared by the whole traversal.
+    SizeTally& tally_;
+    /// True to count the length prefixes of groups.
+    bool lengthPrefixedGroups_;
+    /// Index into SizeTally::groupSizes for this group, or INVALID_GROUP for the root and series entries.
+    unsigned groupIndex_;
+    /// The byte count when the group was created.
+    unsigned long long groupStart_;
+    /// Number of bits in the group's bit block (presence flags, conditionals and bools).
+    unsigned packedBits_{};
+    /// The group's bit block, least significant bit first.
+    PODVector<unsigned char> bits_;
+    /// True if nothing has been written to this group yet (for JSON separators).
+    bool empty_{true};
+    /// Number of entries created in each series, so JSON separators are counted once per series.
+    Urho3D::HashMap<String, unsigned> entries_;
+
+    static constexpr unsigned INVALID_GROUP{0xFFFFFFFF};
+};
+
+}
+}
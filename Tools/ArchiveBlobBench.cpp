@@ -0,0 +1,73 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/JSONFile.h>
+
+#include "../BinaryBackend.h"
+
+using namespace Urho3D;
+
+namespace {
+
+/// Times the function in milliseconds.
+template<class Fn>
+float Time(Fn&& fn)
+{
+    HiresTimer timer;
+    fn();
+    return timer.GetUSec(false) / 1000.0f;
+}
+
+void Report(const String& what, unsigned size, float msec)
+{
+    PrintLine(ToString("%-32s %9.1f ms %9.1f MB/s", what.CString(), msec, size / (1024.0f * 1024.0f) / (msec / 1000.0f)));
+}
+
+}
+
+/// Benchmark of archiving a byte buffer in one piece: ArchiveBlobBench [megabytes], 64 by default.
+/// Compares the binary and JSON (base64) buffer primitives against archiving the same bytes as a series, the only option before backends supported buffers.
+int main(int argc, char** argv)
+{
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    const unsigned size = (arguments.Size() ? ToUInt(arguments[0]) : 64) << 20;
+
+    PODVector<unsigned char> blob(size);
+    unsigned seed = 1;
+    for (unsigned char& byte : blob)
+        byte = static_cast<unsigned char>((seed = seed * 1103515245 + 12345) >> 16);
+    PODVector<unsigned char> loaded;
+
+    VectorBuffer binary;
+    Report("binary buffer write", size, Time([&]() { Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(binary)).Serialize("blob", blob); }));
+    Report("binary buffer read", size, Time([&]()
+    {
+        MemoryBuffer source(binary.GetData(), binary.GetSize());
+        Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(source)).Serialize("blob", loaded);
+    }));
+    if (loaded != blob)
+        PrintLine("binary buffer mismatch", true);
+
+    SharedPtr<Context> context(new Context());
+    JSONFile json(context);
+    json.GetRoot().SetType(JSON_OBJECT);
+    Report("JSON base64 write", size, Time([&]() { Archival::Detail::JSONBackend::MakeArchive(false, json.GetRoot()).Serialize("blob", blob); }));
+    loaded.Clear();
+    Report("JSON base64 read", size, Time([&]() { Archival::Detail::JSONBackend::MakeArchive(true, json.GetRoot()).Serialize("blob", loaded); }));
+    if (loaded != blob)
+        PrintLine("JSON base64 mismatch", true);
+
+    VectorBuffer series;
+    Report("binary series write", size, Time([&]() { Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(series)).SerializeSeries("blob", blob); }));
+    loaded.Clear();
+    Report("binary series read", size, Time([&]()
+    {
+        MemoryBuffer source(series.GetData(), series.GetSize());
+        Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(source)).SerializeSeries("blob", loaded);
+    }));
+    if (loaded != blob)
+        PrintLine("binary series mismatch", true);
+    return 0;
+}
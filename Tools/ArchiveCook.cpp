@@ -0,0 +1,25 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+
+#include "../CookedArchive.h"
+
+using namespace Urho3D;
+
+/// Build time cooker: ArchiveCook <source.json> <cooked>. Writes the cooked binary that CookedArchive::Open prefers over the source while their checksums match.
+int main(int argc, char** argv)
+{
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    if (arguments.Size() != 2)
+    {
+        PrintLine("Usage: ArchiveCook <source.json> <cooked>", true);
+        return 1;
+    }
+
+    SharedPtr<Context> context(new Context());
+    if (!Archival::CookedArchive::Cook(context, arguments[0], arguments[1]))
+    {
+        PrintLine("Cooking " + arguments[0] + " failed.", true);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+#include "../BinaryBackend.h"
+#include "../MaterialArchive.h"
+
+using namespace Urho3D;
+
+namespace {
+
+/// A material archived to the binary layout, and what it loads into.
+struct MaterialJob
+{
+    String name_;
+    VectorBuffer data_;
+    Archival::MaterialDescription description_;
+    bool good_{};
+};
+
+/// Times the function in milliseconds.
+template<class Fn>
+float Time(Fn&& fn)
+{
+    HiresTimer timer;
+    fn();
+    return timer.GetUSec(false) / 1000.0f;
+}
+
+void Report(const String& what, unsigned count, float msec)
+{
+    PrintLine(ToString("%-40s %9.1f ms %9.3f ms/material", what.CString(), msec, msec / Max(count, 1u)));
+}
+
+/// Phase one of a material on a WorkQueue thread.
+void BeginLoadMaterial(const WorkItem* item, unsigned)
+{
+    auto* job = static_cast<MaterialJob*>(item->aux_);
+    MemoryBuffer source(job->data_.GetData(), job->data_.GetSize());
+    Archive ar = Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(source));
+    job->good_ = Archival::MaterialArchive::BeginLoad(ar, "material", job->description_, static_cast<ResourceCache*>(item->start_));
+}
+
+/// Runs frames until the resource cache has finished every background load.
+void FinishBackgroundLoading(Engine* engine, ResourceCache* cache)
+{
+    while (cache->GetNumBackgroundLoadResources())
+        engine->RunFrame();
+}
+
+}
+
+/// Benchmark of two-phase archived material loading against Material::Load: ArchiveMaterialBench <resource dir> [repeats], 1 by default.
+/// Loads every Materials/*.xml of the resource directory natively (synchronously, then through the background loader), and from binary archives with phase one on WorkQueue threads and phase two on the main thread.
+int main(int argc, char** argv)
+{
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    if (arguments.Empty())
+    {
+        PrintLine("Usage: ArchiveMaterialBench <resource dir> [repeats]", true);
+        return 1;
+    }
+    const unsigned repeats = Max(arguments.Size() > 1 ? ToUInt(arguments[1]) : 1u, 1u);
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+    VariantMap parameters;
+    parameters[EP_HEADLESS] = true;
+    parameters[EP_LOG_NAME] = String::EMPTY;
+    parameters[EP_RESOURCE_PATHS] = arguments[0];
+    parameters[EP_RESOURCE_PREFIX_PATHS] = String::EMPTY;
+    if (!engine->Initialize(parameters))
+        return 1;
+    engine->SetMaxFps(0);
+
+    auto* cache = context->GetSubsystem<ResourceCache>();
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    Vector<String> names;
+    context->GetSubsystem<FileSystem>()->ScanDir(names, AddTrailingSlash(cache->GetResourceDirs()[0]) + "Materials/", "*.xml", SCAN_FILES, true);
+    if (names.Empty())
+    {
+        PrintLine("No materials found", true);
+        return 1;
+    }
+
+    // Archive every material once, outside of the timings.
+    Vector<MaterialJob> jobs;
+    for (const String& name : names)
+    {
+        auto* material = cache->GetResource<Material>("Materials/" + name);
+        if (!material)
+            continue;
+        jobs.Resize(jobs.Size() + 1);
+        jobs.Back().name_ = material->GetName();
+        Archival::MaterialDescription description = Archival::MaterialArchive::Describe(*material);
+        Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(jobs.Back().data_)).Serialize("material", description);
+    }
+    const unsigned count = jobs.Size() * repeats;
+    PrintLine(ToString("%u materials, %u worker threads", jobs.Size(), queue->GetNumThreads()));
+
+    cache->ReleaseAllResources(true);
+    Report("Material::Load", count, Time([&]()
+    {
+        for (unsigned i = 0; i < repeats; ++i)
+        {
+            for (const MaterialJob& job : jobs)
+                cache->GetResource<Material>(job.name_);
+            cache->ReleaseAllResources(true);
+        }
+    }));
+
+    Report("Material::Load in the background", count, Time([&]()
+    {
+        for (unsigned i = 0; i < repeats; ++i)
+        {
+            for (const MaterialJob& job : jobs)
+                cache->BackgroundLoadResource<Material>(job.name_);
+            FinishBackgroundLoading(engine, cache);
+            cache->ReleaseAllResources(true);
+        }
+    }));
+
+    Report("MaterialArchive two-phase", count, Time([&]()
+    {
+        for (unsigned i = 0; i < repeats; ++i)
+        {
+            for (MaterialJob& job : jobs)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = BeginLoadMaterial;
+                item->aux_ = &job;
+                item->start_ = cache;
+                item->sendEvent_ = false;
+                queue->AddWorkItem(item);
+            }
+            queue->Complete(M_MAX_UNSIGNED);
+
+            Vector<SharedPtr<Material>> materials;
+            for (MaterialJob& job : jobs)
+            {
+                if (!job.good_)
+                    continue;
+                SharedPtr<Material> material(new Material(context));
+                Archival::MaterialArchive::EndLoad(*material, job.description_);
+                materials.Push(material);
+                job.description_ = Archival::MaterialDescription();
+            }
+            materials.Clear();
+            cache->ReleaseAllResources(true);
+        }
+    }));
+    return 0;
+}
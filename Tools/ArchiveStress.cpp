@@ -0,0 +1,407 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "../ArchiveImage.h"
+#include "../ArchiveStream.h"
+#include "../ArchiveUrhoTypes.h"
+#include "../BinaryBackend.h"
+#include "../JSONDocument.h"
+#include "../SerializableBackend.h"
+#include "../Transcoder.h"
+
+using namespace Urho3D;
+
+namespace {
+
+/// A record with scalars, a string and a nested series.
+struct Record
+{
+    int id_{};
+    float weight_{};
+    String label_;
+    PODVector<int> values_;
+
+    ARCHIVE_FIELDS(Record, ARCHIVE_FIELD_NAMED("id", id_), ARCHIVE_FIELD_NAMED("weight", weight_), ARCHIVE_FIELD_NAMED("label", label_), ARCHIVE_FIELD_NAMED("values", values_))
+
+    bool operator ==(const Record& rhs) const { return id_ == rhs.id_ && weight_ == rhs.weight_ && label_ == rhs.label_ && values_ == rhs.values_; }
+};
+
+/// A fixed-shape value, replayed slot by slot from the instance cache.
+struct Placement
+{
+    float x_{};
+    float y_{};
+    float z_{};
+    String prefab_;
+
+    ARCHIVE_FIELDS(Placement, ARCHIVE_FIELD_NAMED("x", x_), ARCHIVE_FIELD_NAMED("y", y_), ARCHIVE_FIELD_NAMED("z", z_), ARCHIVE_FIELD_NAMED("prefab", prefab_))
+
+    bool operator ==(const Placement& rhs) const { return x_ == rhs.x_ && y_ == rhs.y_ && z_ == rhs.z_ && prefab_ == rhs.prefab_; }
+};
+
+/// Node attributes with mixed-case names, archived as one record through the SerializableBackend.
+struct NodeHeader
+{
+    bool enabled_{};
+    String name_;
+
+    ARCHIVE_FIELDS(NodeHeader, ARCHIVE_FIELD_NAMED("Is Enabled", enabled_), ARCHIVE_FIELD_NAMED("Name", name_))
+};
+
+/// Reads the header of one node into another through their attributes.
+bool AttributeTrip(Context* context)
+{
+    SharedPtr<Node> source(new Node(context));
+    source->SetName("Crate");
+    source->SetEnabled(false);
+    SharedPtr<Node> dest(new Node(context));
+
+    NodeHeader header;
+    if (!Archival::Detail::SerializableBackend::MakeArchive(*source, true).SerializeInline(header) || header.name_ != "Crate" || header.enabled_)
+        return false;
+    if (!Archival::Detail::SerializableBackend::MakeArchive(*dest, false).SerializeInline(header))
+        return false;
+    return dest->GetName() == "Crate" && !dest->IsEnabled();
+}
+
+/// Cooks a JSON vector, stored as an array, into the tagged layout and loads it from there.
+bool CookTrip()
+{
+    JSONValue root(JSON_OBJECT);
+    JSONValue position(JSON_ARRAY);
+    position.Push(1.0f);
+    position.Push(2.0f);
+    position.Push(3.0f);
+    root.Set("position", position);
+
+    VectorBuffer cooked;
+    {
+        Archive input = Archival::Detail::JSONBackend::MakeArchive(true, root);
+        Archive output = Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Serializer&>(cooked));
+        if (!Archival::Transcoder::Transcode(input, output))
+            return false;
+    }
+    MemoryBuffer source(cooked.GetData(), cooked.GetSize());
+    Vector3 loaded;
+    return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Deserializer&>(source)).Serialize("position", loaded) && loaded == Vector3(1.0f, 2.0f, 3.0f);
+}
+
+/// Loads a JSON vector stored as an array of one-component objects.
+bool ComponentTrip()
+{
+    JSONValue root(JSON_OBJECT);
+    JSONValue position(JSON_ARRAY);
+    const char* names[] = {"x", "y", "z"};
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        JSONValue component(JSON_OBJECT);
+        component.Set(names[i], i + 1.0f);
+        position.Push(component);
+    }
+    root.Set("position", position);
+
+    Vector3 loaded;
+    return Archival::Detail::JSONBackend::MakeArchive(true, root).Serialize("position", loaded) && loaded == Vector3(1.0f, 2.0f, 3.0f);
+}
+
+/// Reads a JSON variant of an unknown type, which must fail rather than load as an empty variant. Logs the unknown type.
+bool VariantTrip()
+{
+    JSONValue root(JSON_OBJECT);
+    JSONValue stored(JSON_OBJECT);
+    stored.Set("type", "Vector5");
+    stored.Set("value", 1);
+    root.Set("variant", stored);
+
+    Variant loaded(1);
+    return !Archival::Detail::JSONBackend::MakeArchive(true, root).Serialize("variant", loaded);
+}
+
+/// Writes two sibling groups of the positional layout, closing the first while the second is open, and reads them back. Logs the out of order close.
+bool SiblingTrip()
+{
+    VectorBuffer buffer;
+    {
+        Archive output = Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(buffer));
+        UniquePtr<Archive> first(new Archive(output.CreateGroup("first")));
+        bool flag = true;
+        first->Serialize("flag", flag);
+        Archive second = output.CreateGroup("second");
+        int id = 7;
+        second.Serialize("id", id);
+        first.Reset();
+    }
+    MemoryBuffer source(buffer.GetData(), buffer.GetSize());
+    Archive input = Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(source));
+    bool flag = false;
+    if (!input.CreateGroup("first").Serialize("flag", flag) || !flag)
+        return false;
+    int id = 0;
+    return input.CreateGroup("second").Serialize("id", id) && id == 7;
+}
+
+/// One archive round trip per format, run on a WorkQueue thread.
+struct StressJob
+{
+    unsigned seed_;
+    unsigned records_;
+    /// Document every job reads at once, and the records it holds.
+    const Archival::JSONDocument* document_;
+    const Vector<Record>* documentRecords_;
+    const Placement* documentPlacement_;
+    bool good_{};
+};
+
+/// Generates the records of a job.
+Vector<Record> MakeRecords(unsigned seed, unsigned count)
+{
+    auto next = [&seed]() { return (seed = seed * 1103515245 + 12345) >> 16; };
+    Vector<Record> records(count);
+    for (Record& record : records)
+    {
+        record.id_ = static_cast<int>(next());
+        record.weight_ = (next() & 0xFFF) * 0.25f;
+        record.label_ = "record" + String(next());
+        record.values_.Resize(next() & 7);
+        for (int& value : record.values_)
+            value = static_cast<int>(next()) - 0x4000;
+    }
+    return records;
+}
+
+/// Writes the records and reads them back.
+template<class MakeOutput, class MakeInput>
+bool RoundTrip(const Vector<Record>& records, MakeOutput&& makeOutput, MakeInput&& makeInput)
+{
+    {
+        Vector<Record> source = records;
+        Archive output = makeOutput();
+        if (!output.Serialize("records", source))
+            return false;
+    }
+
+    Archive input = makeInput();
+    Vector<Record> loaded;
+    return input.Serialize("records", loaded) && loaded == records;
+}
+
+/// Streams the records out in small blocks and pulls them back in batches of another size.
+template<class MakeOutput, class MakeInput>
+bool StreamTrip(const Vector<Record>& records, MakeOutput&& makeOutput, MakeInput&& makeInput)
+{
+    {
+        Archive output = makeOutput();
+        Archival::SeriesWriter<Record> writer(output, "stream", 7);
+        for (const Record& record : records)
+            writer.Push(record);
+        if (!writer.Close() || writer.GetCount() != records.Size())
+            return false;
+    }
+
+    Archive input = makeInput();
+    Archival::SeriesReader<Record> reader(input, "stream");
+    Vector<Record> loaded;
+    Vector<Record> batch;
+    while (reader.Pull(batch, 5))
+        loaded.Push(batch);
+    return reader.IsGood() && reader.IsEnd() && loaded == records;
+}
+
+void RunStressJob(const WorkItem* item, unsigned)
+{
+    auto* job = static_cast<StressJob*>(item->aux_);
+    const Vector<Record> records = MakeRecords(job->seed_, job->records_);
+
+    JSONValue json;
+    json.SetType(JSON_OBJECT);
+    bool good = RoundTrip(records,
+        [&]() { return Archival::Detail::JSONBackend::MakeArchive(false, json); },
+        [&]() { return Archival::Detail::JSONBackend::MakeArchive(true, json); });
+
+    // Past the end of a JSON series there is nothing to read, which must fail rather than hand out a value shared between backends.
+    {
+        Archive input = Archival::Detail::JSONBackend::MakeArchive(true, json);
+        Record missing;
+        for (unsigned i = 0; i <= records.Size(); ++i)
+            good &= static_cast<bool>(input.CreateSeriesEntry("records").SerializeInline(missing)) == (i < records.Size());
+    }
+
+    VectorBuffer binary;
+    UniquePtr<MemoryBuffer> source;
+    good &= RoundTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(binary)); },
+        [&]() { source.Reset(new MemoryBuffer(binary.GetData(), binary.GetSize())); return Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(*source)); });
+
+    VectorBuffer tagged;
+    UniquePtr<MemoryBuffer> taggedSource;
+    good &= RoundTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Serializer&>(tagged)); },
+        [&]() { taggedSource.Reset(new MemoryBuffer(tagged.GetData(), tagged.GetSize())); return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Deserializer&>(*taggedSource)); });
+
+    // Interned strings: repeated names and values are written once, so the tagged layout must shrink as soon as a name repeats.
+    VectorBuffer interned;
+    UniquePtr<MemoryBuffer> internedSource;
+    good &= RoundTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(interned), nullptr, true); },
+        [&]() { internedSource.Reset(new MemoryBuffer(interned.GetData(), interned.GetSize())); return Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(*internedSource), false, true); });
+
+    VectorBuffer taggedInterned;
+    UniquePtr<MemoryBuffer> taggedInternedSource;
+    good &= RoundTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Serializer&>(taggedInterned), true); },
+        [&]() { taggedInternedSource.Reset(new MemoryBuffer(taggedInterned.GetData(), taggedInterned.GetSize())); return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Deserializer&>(*taggedInternedSource), true); });
+    good &= records.Size() < 2 || taggedInterned.GetSize() < tagged.GetSize();
+
+    VectorBuffer indexed;
+    UniquePtr<MemoryBuffer> indexedSource;
+    good &= RoundTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeIndexedArchive(static_cast<Serializer&>(indexed)); },
+        [&]() { indexedSource.Reset(new MemoryBuffer(indexed.GetData(), indexed.GetSize())); return Archival::Detail::BinaryBackend::MakeIndexedArchive(static_cast<Deserializer&>(*indexedSource)); });
+
+    // Every record by index, last to first, out of the indexed binary and JSON archives.
+    {
+        MemoryBuffer indexedRecords(indexed.GetData(), indexed.GetSize());
+        Archive binaryInput = Archival::Detail::BinaryBackend::MakeIndexedArchive(static_cast<Deserializer&>(indexedRecords));
+        Archive jsonInput = Archival::Detail::JSONBackend::MakeArchive(true, json);
+        unsigned size = 0;
+        good &= binaryInput.SerializeSeriesSize("records", size) && size == records.Size();
+        for (unsigned i = records.Size(); i-- > 0;)
+        {
+            Record binaryRecord;
+            Record jsonRecord;
+            good &= binaryInput.CreateSeriesEntry("records", i).SerializeInline(binaryRecord) && binaryRecord == records[i];
+            good &= jsonInput.CreateSeriesEntry("records", i).SerializeInline(jsonRecord) && jsonRecord == records[i];
+        }
+        Record missing;
+        good &= !binaryInput.CreateSeriesEntry("records", records.Size()).SerializeInline(missing);
+    }
+
+    // Single values by path, out of the self-describing archives and the indexed binary one.
+    if (!records.Empty())
+    {
+        const unsigned last = records.Size() - 1;
+        const String path = "records[" + String(last) + "]/label";
+        String label;
+        good &= Archival::Detail::JSONBackend::MakeArchive(true, json).SerializePath(path, label) && label == records[last].label_;
+
+        MemoryBuffer taggedPath(tagged.GetData(), tagged.GetSize());
+        int id = 0;
+        good &= Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Deserializer&>(taggedPath)).SerializePath("records[" + String(last) + "]/id", id) && id == records[last].id_;
+
+        // Skipping to the last record reads the definitions of the interned names on the way.
+        MemoryBuffer internedPath(taggedInterned.GetData(), taggedInterned.GetSize());
+        label.Clear();
+        good &= Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Deserializer&>(internedPath), true).SerializePath(path, label) && label == records[last].label_;
+
+        // The indexed layout reaches a record of the series whose size was read through the offset table. Nothing names the fields of the record, or other series,
+        // so paths to them fail rather than read whatever comes next.
+        MemoryBuffer indexedPath(indexed.GetData(), indexed.GetSize());
+        Archive indexedInput = Archival::Detail::BinaryBackend::MakeIndexedArchive(static_cast<Deserializer&>(indexedPath));
+        unsigned size = 0;
+        Record record;
+        good &= indexedInput.SerializeSeriesSize("records", size) && indexedInput.SerializePath("records[" + String(last) + "]", record) && record == records[last];
+        good &= !indexedInput.SerializePath("records[" + String(last) + "]/id", id);
+        good &= !indexedInput.SerializePath("others[0]", record);
+    }
+
+    // The same records as unbounded streams.
+    JSONValue stream;
+    stream.SetType(JSON_OBJECT);
+    good &= StreamTrip(records,
+        [&]() { return Archival::Detail::JSONBackend::MakeArchive(false, stream); },
+        [&]() { return Archival::Detail::JSONBackend::MakeArchive(true, stream); });
+
+    VectorBuffer binaryStream;
+    good &= StreamTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeArchive(static_cast<Serializer&>(binaryStream)); },
+        [&]() { source.Reset(new MemoryBuffer(binaryStream.GetData(), binaryStream.GetSize())); return Archival::Detail::BinaryBackend::MakeArchive(static_cast<Deserializer&>(*source)); });
+
+    VectorBuffer taggedStream;
+    good &= StreamTrip(records,
+        [&]() { return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Serializer&>(taggedStream)); },
+        [&]() { taggedSource.Reset(new MemoryBuffer(taggedStream.GetData(), taggedStream.GetSize())); return Archival::Detail::BinaryBackend::MakeTaggedArchive(static_cast<Deserializer&>(*taggedSource)); });
+
+    // Every job reads the shared document at the same time.
+    Vector<Record> shared;
+    good &= job->document_->MakeArchive().Serialize("records", shared) && shared == *job->documentRecords_;
+
+    // And instantiates it through the instance cache, which captures its image once and replays it after.
+    const auto open = [&]() { return job->document_->MakeArchive(); };
+    Vector<Record> instance;
+    good &= Archival::ArchiveInstanceCache<Vector<Record>>::Instantiate("document", "records", instance, open) && instance == *job->documentRecords_;
+    Placement placement;
+    good &= Archival::ArchiveInstanceCache<Placement>::Instantiate("document", "placement", placement, open) && placement == *job->documentPlacement_;
+
+    job->good_ = good;
+}
+
+}
+
+/// Stress test of concurrent archival: ArchiveStress [jobs] [rounds], 256 and 16 by default.
+/// Runs many independent JSON, binary, tagged, interned and indexed binary round trips (whole and streamed) path queries and indexed reads at once on WorkQueue threads, all also reading one shared JSONDocument directly and through the ArchiveInstanceCache, and checks every result, so that state shared between backends shows up as mismatches (or under a thread sanitizer).
+int main(int argc, char** argv)
+{
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    const unsigned jobCount = arguments.Size() > 0 ? ToUInt(arguments[0]) : 256;
+    const unsigned rounds = arguments.Size() > 1 ? ToUInt(arguments[1]) : 16;
+
+    SharedPtr<Context> context(new Context());
+    RegisterSceneLibrary(context);
+    auto* queue = new WorkQueue(context);
+    context->RegisterSubsystem(queue);
+    queue->CreateThreads(Max(GetNumLogicalCPUs(), 2u) - 1);
+
+    Vector<Record> documentRecords = MakeRecords(0, 256);
+    SharedPtr<JSONFile> file(new JSONFile(context));
+    file->GetRoot().SetType(JSON_OBJECT);
+    Placement documentPlacement{1.5f, -2.0f, 0.25f, "Prefabs/Crate.json"};
+    {
+        Archive output = Archival::Detail::JSONBackend::MakeArchive(false, file->GetRoot());
+        output.Serialize("records", documentRecords);
+        output.Serialize("placement", documentPlacement);
+    }
+    Archival::JSONDocument document(file);
+
+    unsigned failures = 0;
+    // Attribute names are mixed case, so their record hashes must match StringHash.
+    failures += !AttributeTrip(context);
+    // JSON arrays cook to tagged series, which must load as the vectors they were.
+    failures += !CookTrip();
+    failures += !ComponentTrip();
+    // Groups closed out of order must not leave a sibling writing into a freed buffer.
+    failures += !SiblingTrip();
+    failures += !VariantTrip();
+    HiresTimer timer;
+    for (unsigned round = 0; round < rounds; ++round)
+    {
+        Vector<StressJob> jobs(jobCount);
+        for (unsigned i = 0; i < jobCount; ++i)
+        {
+            jobs[i].seed_ = round * jobCount + i + 1;
+            jobs[i].records_ = 1 + i % 64;
+            jobs[i].document_ = &document;
+            jobs[i].documentRecords_ = &documentRecords;
+            jobs[i].documentPlacement_ = &documentPlacement;
+
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = RunStressJob;
+            item->aux_ = &jobs[i];
+            item->sendEvent_ = false;
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+
+        for (const StressJob& job : jobs)
+            failures += !job.good_;
+    }
+
+    PrintLine(ToString("%u round trips on %u threads in %.1f ms, %u failed", jobCount * rounds, queue->GetNumThreads() + 1, timer.GetUSec(false) / 1000.0f, failures));
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/Resource/JSONFile.h>
+
+#include "../BinaryBackend.h"
+#include "../Transcoder.h"
+
+using namespace Urho3D;
+
+/// Returns true if the file is JSON (by extension), otherwise it is treated as the tagged binary layout.
+static bool IsJSONFile(const String& fileName)
+{
+    return fileName.EndsWith(".json", false);
+}
+
+/// Command line pump between archive formats: ArchiveTranscode <input> <output>.
+/// .json files are read/written with the JSONBackend, anything else with the tagged BinaryBackend layout.
+int main(int argc, char** argv)
+{
+    const Vector<String>& arguments = ParseArguments(argc, argv);
+    if (arguments.Size() != 2)
+    {
+        PrintLine("Usage: ArchiveTranscode <input> <output>\n.json files are JSON, anything else is the tagged binary layout.", true);
+        return 1;
+    }
+    const String& inputName = arguments[0];
+    const String& outputName = arguments[1];
+
+    SharedPtr<Context> context(new Context());
+
+    File inputFile(context, inputName, FILE_READ);
+    if (!inputFile.IsOpen())
+    {
+        PrintLine("Could not open " + inputName, true);
+        return 1;
+    }
+
+    // The input JSON has to be parsed up front; the tagged binary layout is streamed from the file.
+    JSONFile inputJSON(context);
+    if (IsJSONFile(inputName) && !inputJSON.Load(inputFile))
+    {
+        PrintLine("Could not parse " + inputName, true);
+        return 1;
+    }
+    Archival::Archive input = IsJSONFile(inputName) ? Archival::Detail::JSONBackend::MakeArchive(true, inputJSON.GetRoot())
+                                                    : Archival::Detail::BinaryBackend::MakeTaggedArchive(inputFile);
+
+    File outputFile(context, outputName, FILE_WRITE);
+    if (!outputFile.IsOpen())
+    {
+        PrintLine("Could not open " + outputName, true);
+        return 1;
+    }
+
+    bool good;
+    if (IsJSONFile(outputName))
+    {
+        JSONFile outputJSON(context);
+        outputJSON.GetRoot() = JSONObject();
+        {
+            Archival::Archive output = Archival::Detail::JSONBackend::MakeArchive(false, outputJSON.GetRoot());
+            good = Archival::Transcoder::Transcode(input, output);
+        }
+        good &= outputJSON.Save(outputFile, "\t");
+    }
+    else
+    {
+        Archival::Archive output = Archival::Detail::BinaryBackend::MakeTaggedArchive(outputFile);
+        good = Archival::Transcoder::Transcode(input, output);
+    }
+
+    if (!good)
+    {
+        PrintLine("Transcoding " + inputName + " to " + outputName + " failed.", true);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "Transcoder.h"
+
+inline namespace Archival {
+
+using Detail::Backend;
+
+bool Transcoder::Transcode(Archive &input, Archive &output)
+{
+    if (!input.IsInput() || output.IsInput())
+    {
+        URHO3D_LOGERROR("Transcoder requires an input archive and an output archive.");
+        return false;
+    }
+    return TranscodeGroup(input.GetBackend(), output.GetBackend());
+}
+
+bool Transcoder::TranscodeEntry(Backend &input, const String &inputName, Backend &output, const String &outputName)
+{
+    Backend::EntryForm form;
+    Detail::RecordFieldType type;
+    if (!input.DescribeEntry(inputName, form, type))
+    {
+        URHO3D_LOGERROR("Transcoder could not describe entry " + input.KeyName(inputName) + " of the " + input.GetBackendName() + " input.");
+        return false;
+    }
+
+    switch (form)
+    {
+    case Backend::GROUP_FORM:
+    {
+        Urho3D::UniquePtr<Backend> inputGroup(input.CreateGroup(inputName, true));
+        Urho3D::UniquePtr<Backend> outputGroup(output.CreateGroup(outputName, false));
+        return inputGroup && outputGroup && TranscodeGroup(*inputGroup, *outputGroup);
+    }
+    case Backend::SERIES_FORM:
+        return TranscodeSeries(input, inputName, output, outputName);
+    case Backend::BUFFER_FORM:
+        return Pump<Urho3D::PODVector<unsigned char>>(input, inputName, output, outputName);
+    default:
+        return TranscodeScalar(input, inputName, output, outputName, type);
+    }
+}
+
+bool Transcoder::TranscodeGroup(Backend &input, Backend &output)
+{
+    Urho3D::StringVector names;
+    if (!input.GetEntryNames(names) || !output.SetEntryNames(names))
+        return false;
+
+    bool good = true;
+    for (const String& name : names)
+        good &= TranscodeEntry(input, name, output, name);
+    return good;
+}
+
+bool Transcoder::TranscodeSeries(Backend &input, const String &inputName, Backend &output, const String &outputName)
+{
+    unsigned size = 0;
+    bool sized = input.GetSeriesSize(inputName, size);
+    if (sized && !output.SetSeriesSize(outputName, size))
+        return false;
+
+    bool good = true;
+    for (unsigned i = 0; !sized || i < size; ++i)
+    {
+        Urho3D::UniquePtr<Backend> inputEntry(input.CreateSeriesEntry(inputName, true));
+        if (!inputEntry)
+            return good && !sized;
+        Urho3D::UniquePtr<Backend> outputEntry(output.CreateSeriesEntry(outputName, false));
+        if (!outputEntry)
+            return false;
+        good &= TranscodeEntry(*inputEntry, inputEntry->InlineName(), *outputEntry, outputEntry->InlineName());
+    }
+    return good;
+}
+
+bool Transcoder::TranscodeScalar(Backend &input, const String &inputName, Backend &output, const String &outputName, Detail::RecordFieldType type)
+{
+    switch (type)
+    {
+    case Detail::RECORD_NONE: return input.Get(inputName, nullptr) && output.Set(outputName, nullptr);
+    case Detail::RECORD_BOOL: return Pump<bool>(input, inputName, output, outputName);
+    case Detail::RECORD_UCHAR: return Pump<unsigned char>(input, inputName, output, outputName);
+    case Detail::RECORD_SCHAR: return Pump<signed char>(input, inputName, output, outputName);
+    case Detail::RECORD_USHORT: return Pump<unsigned short>(input, inputName, output, outputName);
+    case Detail::RECORD_SSHORT: return Pump<signed short>(input, inputName, output, outputName);
+    case Detail::RECORD_UINT: return Pump<unsigned int>(input, inputName, output, outputName);
+    case Detail::RECORD_SINT: return Pump<signed int>(input, inputName, output, outputName);
+    case Detail::RECORD_ULONGLONG: return Pump<unsigned long long>(input, inputName, output, outputName);
+    case Detail::RECORD_SLONGLONG: return Pump<signed long long>(input, inputName, output, outputName);
+    case Detail::RECORD_FLOAT: return Pump<float>(input, inputName, output, outputName);
+    case Detail::RECORD_DOUBLE: return Pump<double>(input, inputName, output, outputName);
+    case Detail::RECORD_STRING: return Pump<String>(input, inputName, output, outputName);
+    }
+    return false;
+}
+
+}
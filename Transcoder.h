@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Archive.h"
+
+inline namespace Archival {
+
+/// Pumps the groups, series, entry names and typed scalars of an input archive into an output archive without any C++ objects in between, e.g. to convert JSON assets to the tagged binary layout and back.
+/// The input backend must be self-describing (Backend::DescribeEntry and GetEntryNames): JSONBackend and BinaryBackend::MakeTaggedArchive are. Any backend can be the output.
+/// Entries are pumped one at a time in the input's order, so a streaming input feeding a streaming output never holds more than the current scalar.
+class Transcoder
+{
+public:
+    /// Transcodes every entry of the input archive's current group into the output archive. Returns false if any entry could not be described, read or written.
+    static bool Transcode(Archive& input, Archive& output);
+
+    /// Transcodes a single entry of the input backend into the output backend under the output name.
+    static bool TranscodeEntry(Detail::Backend& input, const String& inputName, Detail::Backend& output, const String& outputName);
+
+private:
+    /// Transcodes every entry of the input group, announcing the entry names to the output first.
+    static bool TranscodeGroup(Detail::Backend& input, Detail::Backend& output);
+    /// Transcodes a series, entry by entry. Series stored without a size end at the first missing entry.
+    static bool TranscodeSeries(Detail::Backend& input, const String& inputName, Detail::Backend& output, const String& outputName);
+    /// Transcodes a scalar of the described type.
+    static bool TranscodeScalar(Detail::Backend& input, const String& inputName, Detail::Backend& output, const String& outputName, Detail::RecordFieldType type);
+
+    /// Reads the value as T and writes it back out.
+    template<class T>
+    static bool Pump(Detail::Backend& input, const String& inputName, Detail::Backend& output, const String& outputName)
+    {
+        T val{};
+        return input.Get(inputName, val) && output.Set(outputName, val);
+    }
+};
+
+}